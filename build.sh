@@ -27,6 +27,7 @@ fi
 mkdir linux_build
 	
 cd src
+build x86-64-fat
 build x86-64-bmi2
 build x86-64-avx2
 build x86-64-modern
@@ -0,0 +1,387 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "analysis.h"
+#include "evaluate.h"
+#include "experience.h"
+#include "movegen.h"
+#include "position.h"
+#include "thread.h"
+#include "tt.h"
+#include "uci.h"
+#include "syzygy/tbprobe.h"
+
+using std::string;
+
+namespace Stockfish::Analysis {
+
+namespace {
+
+  std::vector<Entry> Jobs;
+  std::atomic<size_t> NextJob;
+  std::atomic<uint64_t> TotalNodes;
+
+
+  // setup() prepares a thread to search the root position of its group. As in
+  // ThreadPool::start_thinking(), the earlier states of a game are shared.
+
+  void setup(Thread* th, const Group& g) {
+
+    th->nodes = th->tbHits = th->nmpMinPly = th->bestMoveChanges = 0;
+    th->rootDepth = th->completedDepth = 0;
+
+    if (g.newGame)
+        th->clear();
+
+    th->rootPos.set(g.fen, Options["UCI_Chess960"], &th->rootState, th);
+
+    if (g.state)
+    {
+        th->rootState = *g.state;
+        th->rootState.accumulator = th->accumulatorStack.push(nullptr, th->rootState.accumulatorId);
+    }
+
+    th->rootMoves.clear();
+
+    for (const auto& m : MoveList<LEGAL>(th->rootPos))
+        th->rootMoves.emplace_back(m);
+  }
+
+
+  // report() prints the result of a search of the batch as a line of keys and
+  // values like the UCI "info" lines.
+
+  void report(const Group& g, Thread* best, size_t idx) {
+
+    const Entry& job = Jobs[idx];
+    std::stringstream ss;
+
+    ss << "analysis " << idx + 1;
+
+    if (!job.id.empty())
+        ss << " id " << job.id;
+
+    if (best->rootMoves.empty())
+        ss << " depth 0 score " << UCI::value(best->rootPos.checkers() ? -VALUE_MATE : VALUE_DRAW)
+           << " nodes 0 time " << now() - g.startTime << " bestmove (none)";
+    else
+    {
+        const Search::RootMove& rm = best->rootMoves[0];
+        Value v = rm.score != -VALUE_INFINITE ? rm.score : rm.previousScore;
+
+        ss << " depth "    << best->completedDepth
+           << " seldepth " << rm.selDepth
+           << " score "    << UCI::value(v == -VALUE_INFINITE ? VALUE_ZERO : v)
+           << " nodes "    << g.nodes_searched()
+           << " time "     << now() - g.startTime
+           << " bestmove " << UCI::move(rm.pv[0], best->rootPos.is_chess960())
+           << " pv";
+
+        for (Move m : rm.pv)
+            ss << " " << UCI::move(m, best->rootPos.is_chess960());
+    }
+
+    TotalNodes += g.nodes_searched();
+
+    sync_cout << ss.str() << sync_endl;
+  }
+
+
+  // analyse() is the driver of a batch analysis: the groups take the positions
+  // of the file in turn until there are none left.
+
+  void analyse(Group& g) {
+
+    for (size_t idx; (idx = NextJob++) < Jobs.size(); )
+        report(g, g.search(Jobs[idx].fen, nullptr, true), idx);
+  }
+
+} // namespace
+
+
+/// read_positions() reads an EPD or FEN file, one position per line. The move
+/// counters of a FEN are optional and an EPD "id" operation labels the entry.
+
+bool read_positions(const string& fileName, std::vector<Entry>& entries) {
+
+  std::ifstream file(fileName);
+
+  if (!file.is_open())
+      return false;
+
+  entries.clear();
+
+  string line, token;
+  while (std::getline(file, line))
+  {
+      std::istringstream is(line);
+      string fen;
+      int fields = 0;
+
+      while (fields < 6 && is >> token)
+      {
+          // After the 4 fields of an EPD come its operations
+          if (fields >= 4 && !std::all_of(token.begin(), token.end(), ::isdigit))
+              break;
+
+          fen += token + " ";
+          ++fields;
+      }
+
+      if (fields < 4 || fen[0] == '#')
+          continue;
+
+      size_t id = line.find("id \"");
+      entries.push_back({ fen, id == string::npos ? "" : line.substr(id + 3, line.find('"', id + 4) - id - 2) });
+  }
+
+  return true;
+}
+
+
+/// Group::search() is called by the driver of a group: all the threads of the
+/// group search the given position, whose previous states are in st when it
+/// comes from a game, and the deepest of them is returned. The histories are
+/// cleared first for a new game or an unrelated position.
+
+Thread* Group::search(const string& rootFen, const StateInfo* st, bool first) {
+
+  Thread* leader = threads.front();
+
+  {
+      std::unique_lock<std::mutex> lk(mutex);
+
+      fen = rootFen;
+      state = st;
+      newGame = first;
+      stop = false;
+      callsCnt = 0;
+      running = threads.size();
+      startTime = now();
+      ++generation;
+      cv.notify_all();
+  }
+
+  TT.new_search();
+  setup(leader, *this);
+
+  if (!leader->rootMoves.empty())
+      leader->Thread::search();
+
+  std::unique_lock<std::mutex> lk(mutex);
+
+  stop = true;
+  --running;
+  cv.notify_all();
+  cv.wait(lk, [&]{ return running == 0; });
+
+  Thread* best = leader;
+
+  for (Thread* th : threads)
+      if (   !th->rootMoves.empty()
+          && std::tie(th->completedDepth, th->rootMoves[0].score) > std::tie(best->completedDepth, best->rootMoves[0].score))
+          best = th;
+
+  return best;
+}
+
+
+/// Group::nodes_searched() returns the nodes searched by the threads of the group
+
+uint64_t Group::nodes_searched() const {
+
+  uint64_t sum = 0;
+  for (Thread* th : threads)
+      sum += th->nodes.load(std::memory_order_relaxed);
+  return sum;
+}
+
+
+/// Group::check_limits() is called at every node: the leader of the group stops
+/// it when the nodes or time limit has been reached, as check_time() does for a
+/// search.
+
+void Group::check_limits(const Thread* th) {
+
+  if (   th != threads.front()
+      || !(Search::Limits.nodes || Search::Limits.movetime)
+      || --callsCnt > 0)
+      return;
+
+  callsCnt = Search::Limits.nodes ? std::min(1024, int(Search::Limits.nodes / 1024)) : 1024;
+
+  if (   (Search::Limits.nodes && nodes_searched() >= uint64_t(Search::Limits.nodes))
+      || (Search::Limits.movetime && now() - startTime >= Search::Limits.movetime))
+      stop = true;
+}
+
+
+/// Analysis::work() is run by each thread of a group in place of search(). The
+/// leader runs the driver of the group, the other threads search each position
+/// it submits until the driver is done.
+
+void work(Thread* th) {
+
+  Group& g = *th->group;
+
+  if (th == g.threads.front())
+  {
+      g.driver(g);
+
+      std::unique_lock<std::mutex> lk(g.mutex);
+      g.done = true;
+      ++g.generation;
+      g.cv.notify_all();
+      return;
+  }
+
+  size_t seen = 0;
+
+  while (true)
+  {
+      {
+          std::unique_lock<std::mutex> lk(g.mutex);
+          g.cv.wait(lk, [&]{ return g.generation != seen; });
+          seen = g.generation;
+
+          if (g.done)
+              return;
+      }
+
+      setup(th, g);
+
+      if (!th->rootMoves.empty())
+          th->Thread::search();
+
+      std::unique_lock<std::mutex> lk(g.mutex);
+      --g.running;
+      g.cv.notify_all();
+  }
+}
+
+
+/// Analysis::start() splits the thread pool in the given number of groups and
+/// runs the driver in each of them with the given limits. It returns when all
+/// the drivers are done, the pool being ready for normal searches again.
+
+void start(size_t slots, const Search::LimitsType& limits, Group::Driver driver) {
+
+  Threads.main()->wait_for_search_finished();
+  Threads.wait_for_clear();
+  Experience::wait_for_loading_finished();
+
+  // Contiguous slices of the pool, the sizes differ by one at most
+  slots = std::clamp(slots, size_t(1), Threads.size());
+  std::vector<Group> groups(slots);
+
+  for (size_t i = 0; i < Threads.size(); ++i)
+  {
+      Group& g = groups[i * slots / Threads.size()];
+      g.driver = driver;
+      g.threads.push_back(Threads[i]);
+      Threads[i]->group = &g;
+      Threads[i]->stop = &g.stop;
+  }
+
+  Search::Limits = limits;
+  Search::Limits.startTime = now();
+  Search::set_batch_mode();
+  Threads.stop = false;
+  Threads.increaseDepth = true;
+  Eval::init(true);
+
+  // Set up the probing limits. The root positions are not ranked with the
+  // tablebases, as this uses global state shared by all the groups.
+  StateInfo st;
+  Position pos;
+  Search::RootMoves none;
+  pos.set("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", false, &st, Threads.main());
+  Tablebases::rank_root_moves(pos, none);
+
+  for (Thread* th : Threads)
+      th->start_searching();
+
+  for (Thread* th : Threads)
+      th->wait_for_search_finished();
+
+  for (Thread* th : Threads)
+  {
+      th->group = nullptr;
+      th->stop = &Threads.stop;
+  }
+}
+
+
+/// Analysis::run() is called when engine receives the "analyse" command:
+///
+///   analyse <file> [depth <d>] [nodes <n>] [movetime <ms>] [slots <k>]
+///
+/// The positions of the file are analysed to the given depth (13 by default),
+/// number of nodes or time, k at a time, by k groups sharing out the threads.
+/// By default every thread analyses its own position. Each result is printed as
+/// soon as it is available and a summary follows on stderr.
+
+void run(std::istream& args) {
+
+  Search::LimitsType limits;
+  string fileName, token;
+  size_t slots = Threads.size();
+
+  args >> fileName;
+
+  while (args >> token)
+      if (token == "depth")          args >> limits.depth;
+      else if (token == "nodes")     args >> limits.nodes;
+      else if (token == "movetime")  args >> limits.movetime;
+      else if (token == "slots")     args >> slots;
+
+  if (!limits.depth && !limits.nodes && !limits.movetime)
+      limits.depth = 13;
+
+  if (!read_positions(fileName, Jobs))
+  {
+      sync_cout << "info string Could not open " << fileName << sync_endl;
+      return;
+  }
+
+  NextJob = 0;
+  TotalNodes = 0;
+  TimePoint elapsed = now();
+
+  start(slots, limits, analyse);
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  std::cerr << "\n==========================="
+            << "\nPositions       : " << Jobs.size()
+            << "\nSlots           : " << std::clamp(slots, size_t(1), Threads.size())
+            << "\nTotal time (ms) : " << elapsed
+            << "\nNodes searched  : " << TotalNodes
+            << "\nNodes/second    : " << 1000 * TotalNodes / elapsed
+            << "\nPositions/hour  : " << 3600000 * Jobs.size() / elapsed << std::endl;
+}
+
+} // namespace Stockfish::Analysis
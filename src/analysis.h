@@ -0,0 +1,81 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYSIS_H_INCLUDED
+#define ANALYSIS_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "search.h"
+
+namespace Stockfish {
+
+class Thread;
+
+namespace Analysis {
+
+/// Group is the slice of the thread pool that searches one position at a time
+/// during a batch analysis or a self-play run. Its first thread leads: it runs
+/// the driver, which submits the positions with Group::search(), and enforces
+/// the limits. The threads keep their own histories, the transposition table is
+/// shared by all the groups.
+
+struct Group {
+
+  typedef void (*Driver)(Group& g);
+
+  Thread* search(const std::string& rootFen, const StateInfo* st, bool first);
+  uint64_t nodes_searched() const;
+  void check_limits(const Thread* th);
+
+  Driver driver = nullptr;
+  std::atomic_bool stop;
+  std::vector<Thread*> threads;
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t generation = 0, running = 0;
+  int callsCnt = 0;
+  TimePoint startTime = 0;
+
+  // The root position of the current search, read by all the threads
+  std::string fen;
+  const StateInfo* state = nullptr;
+  bool newGame = false, done = false;
+};
+
+/// Entry is a position read from an EPD or FEN file, with its optional "id"
+
+struct Entry {
+  std::string fen, id;
+};
+
+bool read_positions(const std::string& fileName, std::vector<Entry>& entries);
+void start(size_t slots, const Search::LimitsType& limits, Group::Driver driver);
+void run(std::istream& args);
+void work(Thread* th);
+
+} // namespace Analysis
+
+} // namespace Stockfish
+
+#endif // #ifndef ANALYSIS_H_INCLUDED
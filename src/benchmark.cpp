@@ -106,6 +106,23 @@ namespace Stockfish {
 /// bench 64 4 5000 current movetime -> search current position with 4 threads for 5 sec
 /// bench 64 1 100000 default nodes -> search default positions for 100K nodes each
 /// bench 16 1 5 default perft -> run a perft 5 on default positions
+/// bench 16 8 6 default perft -> run a perft 6 on default positions with 8 threads
+///
+/// With "smp" after all the parameters, e.g. "bench 64 16 20 default depth mixed smp",
+/// the positions are searched once with each "SMP Mode" to compare time to depth.
+///
+/// With "batch", e.g. "bench 16 1 1000 default eval NNUE batch", the NNUE evaluations
+/// of the positions are computed 1000 times one at a time, then in a batch, to
+/// compare their throughput.
+///
+/// With "nnue", e.g. "bench 16 1 100 default eval NNUE nnue", the stages of the NNUE
+/// evaluation (accumulator refresh and update, feature transform, each layer and
+/// all of them, with and without the fused first layer) are timed on their own, each called 100 times per position with warm caches
+/// and once with cold caches. The results are written in CSV format: time, bytes
+/// read, bandwidth and, where hardware counters are available, instructions per call.
+///
+/// Search speed options can be compared by setting them before the bench, e.g.
+/// "setoption name Prefetch Distance value 0" disables the move look-ahead prefetch.
 
 vector<string> setup_bench(const Position& current, istream& is) {
 
@@ -120,7 +137,7 @@ vector<string> setup_bench(const Position& current, istream& is) {
   string limitType = (is >> token) ? token : "depth";
   string evalType  = (is >> token) ? token : "mixed";
 
-  go = limitType == "eval" ? "eval" : "go " + limitType + " " + limit;
+  go = limitType == "eval" ? "eval " + limit : "go " + limitType + " " + limit;
 
   if (fenFile == "default")
       fens = Defaults;
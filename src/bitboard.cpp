@@ -36,6 +36,11 @@ Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
 Magic RookMagics[SQUARE_NB];
 Magic BishopMagics[SQUARE_NB];
 
+#if defined(USE_FAT_BINARY)
+const bool HasPopCnt = CPU::has(CPU::POPCNT);
+const bool HasPext   = CPU::has(CPU::PEXT);
+#endif
+
 namespace {
 
   Bitboard RookTable[0x19000];  // To store rook attacks
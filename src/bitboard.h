@@ -338,6 +338,14 @@ inline int popcount(Bitboard b) {
 
 #ifndef USE_POPCNT
 
+#if defined(USE_FAT_BINARY)
+  if (HasPopCnt)
+  {
+      asm("popcntq %1, %0" : "=r" (b) : "r" (b));
+      return int(b);
+  }
+#endif
+
   union { Bitboard bb; uint16_t u[4]; } v = { b };
   return PopCnt16[v.u[0]] + PopCnt16[v.u[1]] + PopCnt16[v.u[2]] + PopCnt16[v.u[3]];
 
@@ -0,0 +1,894 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "cluster.h"
+#include "misc.h"
+#include "search.h"
+#include "thread.h"
+#include "tt.h"
+#include "uci.h"
+
+using std::string;
+
+namespace Stockfish::Cluster {
+
+std::atomic<bool> Sharing;
+
+#if !defined(_WIN32)
+
+namespace {
+
+  // The protocol is made of text lines. Besides the UCI commands forwarded by
+  // the coordinator ("position", "go", "stop", "ponderhit", "ucinewgame" and
+  // "setoption" for the options below) the peers exchange:
+  //
+  //   cluster search <id>                                 coordinator -> worker
+  //   cluster tt <key> <value> <eval> <depth> <bound> <pv> <move>   both ways
+  //   cluster result <id> <depth> <score> <nodes> <move>  worker -> coordinator
+
+  const std::set<string> ForwardedOptions = {
+      "UCI_Chess960", "UCI_AnalyseMode", "Use NNUE Evaluation", "Use Classical Evaluation",
+      "EvalFile", "SMP Mode", "Move Overhead", "Slow Mover", "nodestime",
+      "SyzygyProbeDepth", "Syzygy50MoveRule", "SyzygyProbeLimit" };
+
+  struct Result {
+    uint64_t id = 0;
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    string move;
+  };
+
+  // FdBuf is a read only stream buffer over a socket, so that the lines sent
+  // by a peer can be read with std::getline().
+
+  class FdBuf : public std::streambuf {
+  public:
+    explicit FdBuf(int f) : fd(f) {}
+
+  protected:
+    int_type underflow() override {
+
+      ssize_t n;
+      do n = ::read(fd, buf, sizeof(buf)); while (n < 0 && errno == EINTR);
+
+      if (n <= 0)
+          return traits_type::eof();
+
+      setg(buf, buf, buf + n);
+      return traits_type::to_int_type(buf[0]);
+    }
+
+  private:
+    int fd;
+    char buf[4096];
+  };
+
+  // Connection is a link to a peer. Outgoing lines are queued and written by a
+  // dedicated thread, so that a slow peer never stalls the search threads.
+
+  struct Connection {
+
+    explicit Connection(int f) : fd(f), in(f) {
+      writer = std::thread(&Connection::write_loop, this);
+    }
+
+    ~Connection() {
+      stop();
+      if (reader.joinable())
+          reader.join();
+      writer.join();
+      ::close(fd);
+    }
+
+    // send() queues a line. TT entries are dropped rather than queued without
+    // limit when the peer does not keep up.
+    void send(const string& line, bool droppable = false) {
+
+      std::lock_guard<std::mutex> lk(mutex);
+      if (closed || (droppable && outbox.size() > (1 << 20)))
+          return;
+
+      outbox += line;
+      cv.notify_one();
+    }
+
+    void stop() {
+
+      {
+          std::lock_guard<std::mutex> lk(mutex);
+          closed = true;
+      }
+      cv.notify_one();
+      ::shutdown(fd, SHUT_RDWR);
+    }
+
+    void write_loop() {
+
+      while (true)
+      {
+          string data;
+          {
+              std::unique_lock<std::mutex> lk(mutex);
+              cv.wait(lk, [&]{ return closed || !outbox.empty(); });
+              if (closed)
+                  return;
+              data.swap(outbox);
+          }
+
+          for (size_t off = 0; off < data.size(); )
+          {
+              ssize_t n = ::send(fd, data.data() + off, data.size() - off, 0);
+              if (n < 0 && errno == EINTR)
+                  continue;
+              if (n <= 0)
+              {
+                  stop();
+                  return;
+              }
+              off += size_t(n);
+          }
+      }
+    }
+
+    int fd;
+    FdBuf in;
+    std::atomic<bool> closed = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+    string outbox;
+    std::thread reader, writer;
+    uint64_t startId = 0; // Last search the peer was asked to take part in
+    Result result;        // Last result received from the peer
+  };
+
+  std::mutex peersMutex; // Protects the peers and the state of the search below
+  std::condition_variable resultCv;
+  std::vector<std::unique_ptr<Connection>> peers;
+  std::map<string, string> options;
+  string positionCmd = "position startpos";
+  uint64_t searchId, workerNodes;
+  bool worker, suspended, running;
+
+  std::thread acceptor;
+  std::atomic<bool> stopAccept;
+  int listenFd = -1;
+  string unixPath;
+  std::streambuf* stdinBuf;
+
+
+  // open_socket() returns a socket listening on, or connected to, an address
+  // given as "unix:<path>" or "<host>:<port>", or -1 in case of failure.
+
+  int open_socket(const string& address, bool server) {
+
+    if (address.rfind("unix:", 0) == 0)
+    {
+        sockaddr_un sa{};
+        string path = address.substr(5);
+
+        if (path.empty() || path.size() >= sizeof(sa.sun_path))
+            return -1;
+
+        sa.sun_family = AF_UNIX;
+        std::strncpy(sa.sun_path, path.c_str(), sizeof(sa.sun_path) - 1);
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        if (server)
+            ::unlink(path.c_str());
+
+        if (server ? ::bind(fd, (sockaddr*)&sa, sizeof(sa)) < 0 || ::listen(fd, 64) < 0
+                   : ::connect(fd, (sockaddr*)&sa, sizeof(sa)) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    size_t colon = address.rfind(':');
+    if (colon == string::npos)
+        return -1;
+
+    string host = address.substr(0, colon), port = address.substr(colon + 1);
+    addrinfo hints{}, *res;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = server ? AI_PASSIVE : 0;
+
+    if (::getaddrinfo(host.empty() || host == "*" ? nullptr : host.c_str(), port.c_str(), &hints, &res))
+        return -1;
+
+    int fd = -1, one = 1;
+    for (addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next)
+    {
+        if ((fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0)
+            continue;
+
+        if (server)
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        else
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (server ? ::bind(fd, ai->ai_addr, ai->ai_addrlen) < 0 || ::listen(fd, 64) < 0
+                   : ::connect(fd, ai->ai_addr, ai->ai_addrlen) < 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    ::freeaddrinfo(res);
+    return fd;
+  }
+
+
+  // Entry is a TT entry exchanged with the peers
+
+  struct Entry {
+    Key key;
+    int v, ev, d, b, pv, m;
+  };
+
+  std::ostream& operator<<(std::ostream& os, const Entry& e) {
+    return os << "cluster tt " << e.key << " " << e.v << " " << e.ev << " " << e.d
+              << " " << e.b << " " << e.pv << " " << e.m << "\n";
+  }
+
+  // ShareBuffer is a ring of the entries shared by one search thread, written
+  // without locks by its owner and read by the flusher thread.
+
+  struct ShareBuffer {
+
+    static constexpr size_t Size = 4096;
+
+    // push() drops the entry if the flusher does not keep up
+    void push(const Entry& e) {
+
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == Size)
+          return;
+
+      entries[h % Size] = e;
+      head.store(h + 1, std::memory_order_release);
+    }
+
+    template<typename F>
+    void drain(F f) {
+
+      size_t t = tail.load(std::memory_order_relaxed);
+      size_t h = head.load(std::memory_order_acquire);
+
+      for ( ; t != h; ++t)
+          f(entries[t % Size]);
+
+      tail.store(t, std::memory_order_release);
+    }
+
+    Entry entries[Size];
+    std::atomic<size_t> head = 0, tail = 0;
+    std::atomic<bool> owned = false;
+  };
+
+  // The buffers are never freed: when a thread exits its buffer is released
+  // and reused by the next thread sharing an entry.
+
+  std::mutex buffersMutex;
+  std::vector<std::unique_ptr<ShareBuffer>> buffers;
+
+  struct BufferOwner {
+    ~BufferOwner() { if (buffer) buffer->owned.store(false, std::memory_order_release); }
+    ShareBuffer* buffer = nullptr;
+  };
+
+  ShareBuffer& thread_buffer() {
+
+    thread_local BufferOwner owner;
+
+    if (!owner.buffer)
+    {
+        std::lock_guard<std::mutex> lk(buffersMutex);
+
+        for (auto& b : buffers)
+            if (!b->owned.exchange(true, std::memory_order_acquire))
+            {
+                owner.buffer = b.get();
+                break;
+            }
+
+        if (!owner.buffer)
+        {
+            buffers.push_back(std::make_unique<ShareBuffer>());
+            buffers.back()->owned = true;
+            owner.buffer = buffers.back().get();
+        }
+    }
+
+    return *owner.buffer;
+  }
+
+  // The entries received from the peers wait in the inbox until the main thread
+  // stores them in the TT, see Cluster::apply().
+
+  std::mutex inboxMutex;
+  std::vector<Entry> inbox;
+
+  std::thread flusher;
+  std::atomic<bool> stopFlush;
+
+
+  // receive_tt() queues a TT entry sent by a peer and, on the coordinator,
+  // relays it to the other workers.
+
+  void receive_tt(std::istream& is, Connection* from) {
+
+    Entry e;
+
+    if (   !(is >> e.key >> e.v >> e.ev >> e.d >> e.b >> e.pv >> e.m)
+        || !Sharing
+        || e.d <= DEPTH_OFFSET || e.d >= MAX_PLY
+        || e.b < BOUND_UPPER || e.b > BOUND_EXACT
+        || std::abs(e.v) > VALUE_NONE || std::abs(e.ev) > VALUE_NONE)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(inboxMutex);
+        if (inbox.size() < (1 << 16))
+            inbox.push_back(e);
+    }
+
+    if (from)
+    {
+        std::ostringstream ss;
+        ss << e;
+
+        std::lock_guard<std::mutex> lk(peersMutex);
+        for (auto& c : peers)
+            if (c.get() != from)
+                c->send(ss.str(), true);
+    }
+  }
+
+
+  // flush_loop() sends the entries shared by the search threads to the peers,
+  // in batches so that peersMutex is taken once per millisecond at most.
+
+  void flush_loop() {
+
+    while (!stopFlush)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        std::ostringstream ss;
+        bool sharing = Sharing;
+        {
+            std::lock_guard<std::mutex> lk(buffersMutex);
+            for (auto& b : buffers)
+                b->drain([&](const Entry& e) { if (sharing) ss << e; });
+        }
+
+        string batch = ss.str();
+        if (batch.empty())
+            continue;
+
+        std::lock_guard<std::mutex> lk(peersMutex);
+        for (auto& c : peers)
+            c->send(batch, true);
+    }
+  }
+
+
+  // read_loop() handles the lines sent by a worker to the coordinator
+
+  void read_loop(Connection* c) {
+
+    std::istream is(&c->in);
+    string line, token;
+
+    while (std::getline(is, line))
+    {
+        std::istringstream ls(line);
+
+        if (!(ls >> token) || token != "cluster" || !(ls >> token))
+            continue;
+
+        if (token == "tt")
+            receive_tt(ls, c);
+
+        else if (token == "result")
+        {
+            Result r;
+            if (ls >> r.id >> r.depth >> r.score >> r.nodes >> r.move)
+            {
+                std::lock_guard<std::mutex> lk(peersMutex);
+                c->result = r;
+            }
+            resultCv.notify_all();
+        }
+    }
+
+    c->stop();
+    {
+        std::lock_guard<std::mutex> lk(peersMutex);
+    }
+    resultCv.notify_all();
+  }
+
+
+  // accept_loop() runs on the coordinator and welcomes the new workers
+
+  void accept_loop() {
+
+    while (!stopAccept)
+    {
+        pollfd p = { listenFd, POLLIN, 0 };
+        if (::poll(&p, 1, 100) <= 0)
+            continue;
+
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        int one = 1; // Fails harmlessly on Unix sockets
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto c = std::make_unique<Connection>(fd);
+        c->reader = std::thread(read_loop, c.get());
+
+        std::lock_guard<std::mutex> lk(peersMutex);
+        for (const auto& [name, value] : options)
+            c->send("setoption name " + name + " value " + value + "\n");
+
+        peers.push_back(std::move(c));
+        sync_cout << "info string Cluster worker connected" << sync_endl;
+    }
+  }
+
+
+  // connect_worker() turns this process into a worker of the coordinator at
+  // the given address: from now on the UCI commands are read from the socket.
+
+  void connect_worker(const string& address) {
+
+    if (worker || listenFd >= 0)
+    {
+        sync_cout << "info string Cluster already started" << sync_endl;
+        return;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Give a coordinator started at the same time one minute to come up
+    int fd = -1;
+    for (int i = 0; i < 60 && (fd = open_socket(address, false)) < 0; ++i)
+    {
+        if (!i)
+            sync_cout << "info string Cluster waiting for " << address << sync_endl;
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    if (fd < 0)
+    {
+        sync_cout << "info string Cluster cannot connect to " << address << sync_endl;
+        return;
+    }
+
+    // Several workers must not write to the same experience file
+    Options["Experience Readonly"] = string("true");
+
+    std::lock_guard<std::mutex> lk(peersMutex);
+    peers.push_back(std::make_unique<Connection>(fd));
+    stdinBuf = std::cin.rdbuf(&peers.back()->in);
+    worker = true;
+    Sharing = true;
+    flusher = std::thread(flush_loop);
+
+    sync_cout << "info string Cluster worker connected to " << address << sync_endl;
+  }
+
+} // namespace
+
+
+/// Cluster::listen() makes this process the coordinator of a cluster, waiting
+/// for workers on the given address. It is called when "Cluster Listen" changes.
+
+void listen(const string& address) {
+
+  close();
+
+  if (address.empty() || address == "<empty>")
+      return;
+
+  std::signal(SIGPIPE, SIG_IGN);
+
+  if ((listenFd = open_socket(address, true)) < 0)
+  {
+      sync_cout << "info string Cluster cannot listen on " << address << sync_endl;
+      return;
+  }
+
+  unixPath = address.rfind("unix:", 0) == 0 ? address.substr(5) : "";
+  acceptor = std::thread(accept_loop);
+  flusher = std::thread(flush_loop);
+
+  sync_cout << "info string Cluster listening on " << address << sync_endl;
+}
+
+
+/// Cluster::close() disconnects all the peers and stops listening
+
+void close() {
+
+  if (acceptor.joinable())
+  {
+      stopAccept = true;
+      acceptor.join();
+      stopAccept = false;
+  }
+
+  if (flusher.joinable())
+  {
+      stopFlush = true;
+      flusher.join();
+      stopFlush = false;
+  }
+
+  if (listenFd >= 0)
+  {
+      ::close(listenFd);
+      listenFd = -1;
+      if (!unixPath.empty())
+          ::unlink(unixPath.c_str());
+  }
+
+  std::vector<std::unique_ptr<Connection>> old; // Joined after the unlock below
+  std::lock_guard<std::mutex> lk(peersMutex);
+
+  old.swap(peers);
+  running = false;
+  Sharing = false;
+
+  std::lock_guard<std::mutex> lk2(inboxMutex);
+  inbox.clear();
+
+  if (worker)
+  {
+      std::cin.rdbuf(stdinBuf);
+      worker = false;
+  }
+}
+
+
+/// Cluster::command() handles the "cluster" command: "cluster worker <address>
+/// [threads] [hash]" connects to a coordinator, the other forms are sent by the
+/// coordinator.
+/// Without arguments the state of the cluster is printed.
+
+void command(std::istream& is) {
+
+  string token;
+  is >> token;
+
+  if (token == "worker" && is >> token)
+  {
+      // Optional number of threads and hash size of the worker
+      string threads, hash;
+      if (is >> threads)
+          Options["Threads"] = threads;
+      if (is >> hash)
+          Options["Hash"] = hash;
+
+      connect_worker(token);
+  }
+
+  else if (token == "search")
+  {
+      std::lock_guard<std::mutex> lk(peersMutex);
+      is >> searchId;
+  }
+
+  else if (token == "tt")
+      receive_tt(is, nullptr);
+
+  else
+      sync_cout << "info string Cluster " << (worker ? "worker" : listenFd >= 0 ? "coordinator" : "off")
+                << ", workers " << workers() << sync_endl;
+}
+
+
+/// Cluster::position() records the "position" command to be sent with the next "go"
+
+void position(const string& cmd) {
+
+  std::lock_guard<std::mutex> lk(peersMutex);
+  positionCmd = cmd;
+}
+
+
+/// Cluster::forward() sends a UCI command to all the workers
+
+void forward(const string& cmd) {
+
+  std::lock_guard<std::mutex> lk(peersMutex);
+
+  if (!worker && !suspended)
+      for (auto& c : peers)
+          c->send(cmd + "\n");
+}
+
+
+/// Cluster::forward_option() sends the options that change the search to the
+/// workers, also to the ones connecting later. Options about the resources of
+/// each process, like Threads or Hash, are set on the worker command line.
+
+void forward_option(const string& name, const string& value) {
+
+  if (!ForwardedOptions.count(name))
+      return;
+
+  std::lock_guard<std::mutex> lk(peersMutex);
+
+  if (worker)
+      return;
+
+  options[name] = value;
+  for (auto& c : peers)
+      c->send("setoption name " + name + " value " + value + "\n");
+}
+
+
+/// Cluster::start() is called by the coordinator before a search starts, it
+/// sends the current position and the given "go" command to the workers.
+
+void start(const string& goCmd) {
+
+  std::vector<std::unique_ptr<Connection>> dead; // Joined after the unlock below
+  std::lock_guard<std::mutex> lk(peersMutex);
+
+  for (auto& c : peers)
+      if (c->closed)
+          dead.push_back(std::move(c));
+
+  peers.erase(std::remove(peers.begin(), peers.end(), nullptr), peers.end());
+  workerNodes = 0;
+
+  {
+      // Entries received after the previous search belong to another position
+      std::lock_guard<std::mutex> lk2(inboxMutex);
+      inbox.clear();
+  }
+
+  if (worker || suspended || peers.empty())
+      return;
+
+  ++searchId;
+
+  for (auto& c : peers)
+  {
+      c->startId = searchId;
+      c->send("cluster search " + std::to_string(searchId) + "\n" + positionCmd + "\n" + goCmd + "\n");
+  }
+
+  running = Sharing = true;
+}
+
+
+/// Cluster::finish() is called by the main thread when the search is over. A
+/// worker sends its result to the coordinator, which stops the workers and
+/// waits for their results. If 'vote' is set, the deepest result (the best
+/// score among equal depths) replaces the local best move, in which case true
+/// is returned.
+
+bool finish(Thread* bestThread, bool vote) {
+
+  Search::RootMoves& rootMoves = bestThread->rootMoves;
+  std::unique_lock<std::mutex> lk(peersMutex);
+
+  if (worker)
+  {
+      if (!peers.empty())
+          peers[0]->send(  "cluster result " + std::to_string(searchId)
+                         + " " + std::to_string(bestThread->completedDepth)
+                         + " " + std::to_string(rootMoves[0].score)
+                         + " " + std::to_string(Threads.nodes_searched())
+                         + " " + UCI::move(rootMoves[0].pv[0], bestThread->rootPos.is_chess960()) + "\n");
+      return false;
+  }
+
+  if (!running)
+      return false;
+
+  running = Sharing = false;
+
+  auto taking_part = [](const std::unique_ptr<Connection>& c) { return c->startId == searchId; };
+
+  for (auto& c : peers)
+      if (taking_part(c))
+          c->send("stop\n");
+
+  resultCv.wait_for(lk, std::chrono::seconds(5), [&]{
+      return std::none_of(peers.begin(), peers.end(), [&](const auto& c) {
+          return taking_part(c) && !c->closed && c->result.id != searchId; });
+  });
+
+  Result best;
+  size_t cnt = 0;
+
+  for (auto& c : peers)
+      if (c->result.id == searchId)
+      {
+          workerNodes += c->result.nodes;
+          if (!cnt++ || std::tie(c->result.depth, c->result.score) > std::tie(best.depth, best.score))
+              best = c->result;
+      }
+
+  lk.unlock();
+
+  if (!cnt)
+      return false;
+
+  bool overruled = false;
+
+  if (   vote
+      && std::tie(best.depth, best.score) > std::tie(bestThread->completedDepth, rootMoves[0].score))
+  {
+      Move m = UCI::to_move(bestThread->rootPos, best.move);
+      auto it = std::find(rootMoves.begin(), rootMoves.end(), m);
+
+      if (m != MOVE_NONE && it != rootMoves.end())
+      {
+          std::rotate(rootMoves.begin(), it, it + 1);
+          rootMoves[0].score = rootMoves[0].previousScore = Value(best.score);
+          rootMoves[0].pv.resize(1);
+          bestThread->completedDepth = best.depth;
+          overruled = true;
+      }
+  }
+
+  sync_cout << "info string Cluster workers " << cnt << " nodes " << workerNodes
+            << " bestmove from " << (overruled ? "worker" : "coordinator") << sync_endl;
+
+  return overruled;
+}
+
+
+/// Cluster::share() queues a TT entry to be sent to the peers by the flusher
+/// thread. It is called by the search threads and never blocks.
+
+void share(Key key, Value v, bool pv, Bound b, Depth d, Move m, Value ev) {
+
+  thread_buffer().push({ key, int(v), int(ev), int(d), int(b), int(pv), int(m) });
+}
+
+
+/// Cluster::apply() stores in the TT the entries received from the peers. It
+/// is called by the main thread during the search, when the TT cannot be
+/// resized or cleared.
+
+void apply() {
+
+  std::vector<Entry> entries;
+  {
+      std::lock_guard<std::mutex> lk(inboxMutex);
+      entries.swap(inbox);
+  }
+
+  for (const Entry& e : entries)
+  {
+      bool found;
+      TTEntry* tte = TT.probe(e.key, found);
+      if (!found || tte->depth() < e.d)
+          tte->save(e.key, Value(e.v), bool(e.pv), Bound(e.b), Depth(e.d), Move(e.m), Value(e.ev));
+  }
+}
+
+
+/// Cluster::suspend() lets the coordinator search alone, e.g. to compare with
+/// the cluster in bench.
+
+void suspend(bool s) {
+
+  std::lock_guard<std::mutex> lk(peersMutex);
+  suspended = s;
+}
+
+
+/// Cluster::is_worker() tells whether this process is a worker
+
+bool is_worker() {
+  return worker;
+}
+
+
+/// Cluster::workers() returns the number of workers connected to the coordinator
+
+size_t workers() {
+
+  std::lock_guard<std::mutex> lk(peersMutex);
+  return worker ? 0 : std::count_if(peers.begin(), peers.end(), [](const auto& c) { return !c->closed; });
+}
+
+
+/// Cluster::nodes_searched() returns the nodes searched by the workers in the
+/// last search.
+
+uint64_t nodes_searched() {
+
+  std::lock_guard<std::mutex> lk(peersMutex);
+  return workerNodes;
+}
+
+#else
+
+// Sockets are not supported on Windows yet, a cluster cannot be started
+
+void listen(const string& address) {
+  if (!address.empty() && address != "<empty>")
+      sync_cout << "info string Cluster is not supported on this platform" << sync_endl;
+}
+
+void command(std::istream&) {
+  sync_cout << "info string Cluster is not supported on this platform" << sync_endl;
+}
+
+void close() {}
+void position(const string&) {}
+void forward(const string&) {}
+void forward_option(const string&, const string&) {}
+void start(const string&) {}
+bool finish(Thread*, bool) { return false; }
+void share(Key, Value, bool, Bound, Depth, Move, Value) {}
+void apply() {}
+void suspend(bool) {}
+bool is_worker() { return false; }
+size_t workers() { return 0; }
+uint64_t nodes_searched() { return 0; }
+
+#endif
+
+} // namespace Stockfish::Cluster
@@ -0,0 +1,70 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLUSTER_H_INCLUDED
+#define CLUSTER_H_INCLUDED
+
+#include <atomic>
+#include <istream>
+#include <string>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Thread;
+
+/// The Cluster namespace spreads a search over several SugaR processes, on one
+/// or more hosts. The coordinator listens on a Unix or TCP socket (option
+/// "Cluster Listen") and the workers, started with "cluster worker <address>",
+/// connect to it. For every "go" the coordinator sends the position and the
+/// limits to the workers, each of them searching with its own ThreadPool. Deep
+/// transposition table entries are exchanged through the coordinator and, when
+/// the search ends, the deepest result of all the processes is played.
+
+namespace Cluster {
+
+extern std::atomic<bool> Sharing; // Set while TT entries are sent to the peers
+
+void listen(const std::string& address);
+void close();
+void command(std::istream& is);
+void position(const std::string& cmd);
+void forward(const std::string& cmd);
+void forward_option(const std::string& name, const std::string& value);
+void start(const std::string& goCmd);
+bool finish(Thread* bestThread, bool vote);
+void share(Key key, Value v, bool pv, Bound b, Depth d, Move m, Value ev);
+void apply();
+void suspend(bool s);
+bool is_worker();
+size_t workers();
+uint64_t nodes_searched();
+
+/// should_share() tells whether an entry just written to the TT is deep enough
+/// to be worth sending to the other processes.
+
+inline bool should_share(bool pvNode, Depth d) {
+  return Sharing.load(std::memory_order_relaxed) && d >= (pvNode ? 6 : 12);
+}
+
+} // namespace Cluster
+
+} // namespace Stockfish
+
+#endif // #ifndef CLUSTER_H_INCLUDED
@@ -66,6 +66,38 @@ namespace Eval {
   bool useClassical;
   string eval_file_loaded = "None";
 
+  namespace {
+
+    // checksum() reads a stream and computes its size and a checksum of its
+    // bytes, 8 at a time. Returns false if the stream is empty.
+    bool checksum(istream& stream, uint64_t& size, uint64_t& sum) {
+
+      char buffer[1 << 16];
+      size = 0;
+      sum = 0xcbf29ce484222325ULL;
+
+      while (stream.read(buffer, sizeof(buffer)) || stream.gcount())
+      {
+          size_t n = size_t(stream.gcount()), i = 0;
+          uint64_t word;
+
+          for ( ; i + 8 <= n; i += 8)
+          {
+              memcpy(&word, buffer + i, 8);
+              sum = (sum ^ word) * 0x100000001b3ULL;
+          }
+
+          for ( ; i < n; ++i)
+              sum = (sum ^ uint8_t(buffer[i])) * 0x100000001b3ULL;
+
+          size += n;
+      }
+
+      return size > 0;
+    }
+
+  } // namespace
+
   /// NNUE::init() tries to load a NNUE network at startup time, or when the engine
   /// receives a UCI command "setoption name EvalFile value nn-[a-z0-9]{12}.nnue"
   /// The name of the NNUE network is always retrieved from the EvalFile option.
@@ -97,31 +129,60 @@ namespace Eval {
     vector<string> dirs = { "" };
 #endif
 
-    for (string directory : dirs)
-        if (eval_file_loaded != eval_file)
+    // C++ way to prepare a buffer for a memory stream
+    class MemoryBuffer : public basic_streambuf<char> {
+        public: MemoryBuffer(char* p, size_t n) { setg(p, p, p + n); setp(p, p + n); }
+    };
+
+    // Call f with the stream of the network in each location, until it succeeds
+    auto for_each_stream = [&](auto f) {
+
+        for (string directory : dirs)
         {
             if (directory != "<internal>")
             {
                 ifstream stream(directory + eval_file, ios::binary);
-                if (load_eval(eval_file, stream))
-                    eval_file_loaded = eval_file;
+                if (f(stream))
+                    return true;
             }
 
             if (directory == "<internal>" && eval_file == EvalFileDefaultName)
             {
-                // C++ way to prepare a buffer for a memory stream
-                class MemoryBuffer : public basic_streambuf<char> {
-                    public: MemoryBuffer(char* p, size_t n) { setg(p, p, p + n); setp(p, p + n); }
-                };
-
                 MemoryBuffer buffer(const_cast<char*>(reinterpret_cast<const char*>(gEmbeddedNNUEData)),
                                     size_t(gEmbeddedNNUESize));
 
                 istream stream(&buffer);
-                if (load_eval(eval_file, stream))
-                    eval_file_loaded = eval_file;
+                if (f(stream))
+                    return true;
             }
         }
+        return false;
+    };
+
+    auto load = [&]() {
+
+        if (for_each_stream([&](istream& stream) { return load_eval(eval_file, stream); }))
+            eval_file_loaded = eval_file;
+
+        return eval_file_loaded == eval_file;
+    };
+
+    string shared = Options["EvalFile Shared Name"];
+    uint64_t netSize = 0, netChecksum = 0;
+
+    if (shared.empty() || shared == "<empty>")
+        load();
+
+    // The processes sharing the weights must have the same network file
+    else if (!for_each_stream([&](istream& stream) { return checksum(stream, netSize, netChecksum); }))
+        load();
+
+    else if (share_eval(shared, eval_file, netSize, netChecksum, load))
+        eval_file_loaded = eval_file;
+
+    // The cached accumulators belong to the previous network
+    for (Thread* th : Threads)
+        th->accumulatorCache.netId = 0;
   }
 
   /// NNUE::verify() verifies that the last net used was loaded successfully
@@ -19,6 +19,7 @@
 #ifndef EVALUATE_H_INCLUDED
 #define EVALUATE_H_INCLUDED
 
+#include <functional>
 #include <string>
 #include <optional>
 
@@ -47,13 +48,21 @@ namespace Eval {
 
     std::string trace(Position& pos);
     Value evaluate(const Position& pos, bool adjusted = false);
+    void evaluate(const Position* const positions[], std::size_t count, Value values[], bool adjusted = false);
+    void benchmark(Position* const positions[], std::size_t count, int passes, std::ostream& os);
 
     void init();
     void verify();
 
     bool load_eval(std::string name, std::istream& stream);
-    bool save_eval(std::ostream& stream);
-    bool save_eval(const std::optional<std::string>& filename);
+    bool save_eval(std::ostream& stream, bool compressed = false);
+    bool save_eval(const std::optional<std::string>& filename, bool compressed = false);
+    bool share_eval(const std::string& segment, const std::string& name,
+                    std::uint64_t netSize, std::uint64_t netChecksum, const std::function<bool()>& load);
+
+#if defined(USE_FAT_BINARY)
+    const char* instruction_sets();
+#endif
 
   } // namespace NNUE
 
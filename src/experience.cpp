@@ -827,14 +827,17 @@ namespace Experience
                             bool loadingResult = _load(filename);
                             _loadingResult.store(loadingResult, memory_order_relaxed);
 
-                            //Copy pointer of loader thread so that we can
-                            //clear the variable now and and deleted later
-                            thread *t = _loaderThread;
-                            _loaderThread = nullptr;
-
                             //Notify
+                            thread *t;
                             {
                                 lock_guard<mutex> lg2(_loaderMutex);
+
+                                //Copy pointer of loader thread so that we can
+                                //clear the variable now and and deleted later.
+                                //The lock makes sure it has been assigned already
+                                t = _loaderThread;
+                                _loaderThread = nullptr;
+
                                 _loading = false;
                                 _loadingCond.notify_one();
                             }
@@ -926,6 +929,17 @@ namespace Experience
                 return itr->second;
             }
 
+            void prefetch(Key k)
+            {
+#if defined(USE_GOOGLE_SPARSEHASH_DENSEMAP) && defined(USE_CUSTOM_HASHER)
+                //Preload the bucket where a lookup of 'k' starts probing
+                if (_mainExp.bucket_count())
+                    Stockfish::prefetch(&*_mainExp.begin(KeyHasher()(k) & (_mainExp.bucket_count() - 1)));
+#else
+                (void)k;
+#endif
+            }
+
             void add_pv_experience(Key k, Move m, Value v, Depth d)
             {
                 ExpEntryEx* exp = new ExpEntryEx(k, m, v, d, 1);
@@ -1010,6 +1024,12 @@ namespace Experience
         return currentExperience->probe(k);
     }
 
+    void prefetch(Key k)
+    {
+        if (currentExperience)
+            currentExperience->prefetch(k);
+    }
+
     void wait_for_loading_finished()
     {
         if (!currentExperience)
@@ -210,6 +210,7 @@ namespace Experience
     void wait_for_loading_finished();
 
     const ExpEntryEx* probe(Stockfish::Key k);
+    void prefetch(Stockfish::Key k);
 
     void defrag(int argc, char* argv[]);
     void merge(int argc, char* argv[]);
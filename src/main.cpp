@@ -19,6 +19,7 @@
 #include <iostream>
 
 #include "bitboard.h"
+#include "cluster.h"
 #include "endgame.h"
 #include "misc.h"
 #include "polybook.h"
@@ -62,6 +63,7 @@ int main(int argc, char* argv[]) {
   Endgames::init();
   Experience::init();
   Threads.set(size_t(Options["Threads"]));
+  std::cout << "Hash memory pages     : " << large_pages_info(TT.memory()) << std::endl << std::endl;
   polybook[0].init(Options["Book1 File"]);
   polybook[1].init(Options["Book2 File"]);
   Search::clear(); // After threads are up
@@ -69,6 +71,7 @@ int main(int argc, char* argv[]) {
 
   UCI::loop(argc, argv);
 
+  Cluster::close();
   Experience::unload();
   Threads.set(0);
   return 0;
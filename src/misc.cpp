@@ -40,6 +40,8 @@ typedef bool(*fun3_t)(HANDLE, CONST GROUP_AFFINITY*, PGROUP_AFFINITY);
 }
 #endif
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iomanip>
@@ -48,6 +50,8 @@ typedef bool(*fun3_t)(HANDLE, CONST GROUP_AFFINITY*, PGROUP_AFFINITY);
 #include <vector>
 #include <bitset>
 #include <cstdlib>
+#include <map>
+#include <mutex>
 #include <regex>
 
 #ifdef __GNUC__
@@ -61,8 +65,21 @@ typedef bool(*fun3_t)(HANDLE, CONST GROUP_AFFINITY*, PGROUP_AFFINITY);
 #endif
 
 #if defined(__linux__) && !defined(__ANDROID__)
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #if defined(__APPLE__) || defined(__ANDROID__) || defined(__OpenBSD__) || (defined(__GLIBCXX__) && !defined(_GLIBCXX_HAVE_ALIGNED_ALLOC) && !defined(_WIN32)) || defined(__e2k__)
@@ -70,6 +87,11 @@ typedef bool(*fun3_t)(HANDLE, CONST GROUP_AFFINITY*, PGROUP_AFFINITY);
 #include <stdlib.h>
 #endif
 
+#if defined(USE_FAT_BINARY)
+#include <cpuid.h>
+#endif
+
+#include "evaluate.h"
 #include "misc.h"
 #include "thread.h"
 
@@ -336,6 +358,10 @@ std::string compiler_info() {
 
   compiler += "\nCompilation settings include: ";
   compiler += (Is64Bit ? " 64bit" : " 32bit");
+  #if defined(USE_FAT_BINARY)
+    compiler += " FAT, selected for this CPU:";
+    compiler += Eval::NNUE::instruction_sets();
+  #endif
   #if defined(USE_VNNI)
     compiler += " VNNI";
   #endif
@@ -1093,6 +1119,53 @@ std::ostream& operator<<(std::ostream& os, SyncCout sc) {
 void start_logger(const std::string& fname) { Logger::start(fname); }
 
 
+#if defined(USE_FAT_BINARY)
+
+/// CPU::has() checks the CPUID flags of a feature and, for the AVX extensions,
+/// that the OS saves the registers. Pext is microcoded and slow on AMD before
+/// Zen 3, where the magic bitboards are faster.
+
+bool CPU::has(Feature f) {
+
+  unsigned eax, ebx, ecx, edx, ecx1, ebx7 = 0, ecx7 = 0, xcr0 = 0;
+  char vendor[13] = {};
+
+  __cpuid(0, eax, ebx, ecx, edx);
+  std::memcpy(vendor, &ebx, 4);
+  std::memcpy(vendor + 4, &edx, 4);
+  std::memcpy(vendor + 8, &ecx, 4);
+
+  if (eax >= 7)
+      __cpuid_count(7, 0, eax, ebx7, ecx7, edx);
+
+  __cpuid(1, eax, ebx, ecx1, edx);
+
+  if (ecx1 & (1 << 27)) // OSXSAVE
+      asm("xgetbv" : "=a" (xcr0), "=d" (edx) : "c" (0));
+
+  unsigned family = (eax >> 8) & 0xF;
+  if (family == 0xF)
+      family += (eax >> 20) & 0xFF;
+
+  bool avx    = (xcr0 & 0x06) == 0x06 && (ecx1 & (1 << 28));
+  bool avx512 = avx && (xcr0 & 0xE0) == 0xE0;
+
+  switch (f)
+  {
+  case POPCNT: return ecx1 & (1 << 23);
+  case PEXT:   return (ebx7 & (1 << 8)) && !(std::string(vendor) == "AuthenticAMD" && family < 0x19);
+  case SSSE3:  return ecx1 & (1 << 9);
+  case SSE41:  return ecx1 & (1 << 19);
+  case AVX2:   return avx && (ebx7 & (1 << 5));
+  case AVX512: return avx512 && (ebx7 & (1 << 16)) && (ebx7 & (1 << 30)); // F and BW
+  case VNNI:   return avx512 && (ebx7 & (1 << 17)) && (ebx7 & (1u << 31)) && (ecx7 & (1 << 11)); // DQ, VL and VNNI
+  }
+
+  return false;
+}
+
+#endif
+
 /// prefetch() preloads the given address in L1/L2 cache. This is a non-blocking
 /// function that doesn't stall the CPU waiting for data to be loaded from memory,
 /// which can be quite slow.
@@ -1148,6 +1221,45 @@ void std_aligned_free(void* ptr) {
 }
 
 /// aligned_large_pages_alloc() will return suitably aligned memory, if possible using large pages.
+/// The pageSize argument selects the kind of pages: 0 is the platform default (large
+/// pages on Windows, transparent huge pages on Linux), 4096 disables large pages, and
+/// on Linux bigger values request explicit hugetlbfs pages of that size (2MB or 1GB),
+/// falling back to the default when none are reserved. We remember the page size
+/// obtained for each block, both for reporting and to release it the right way.
+
+namespace {
+
+  struct LargePagesBlock {
+    size_t size;
+    size_t pageSize; // 0 means transparent huge pages
+    bool mapped;     // Allocated with mmap(), to be released with munmap()
+  };
+
+  // Never destroyed, global objects such as TT free their memory at exit
+  std::mutex& largePagesMutex = *new std::mutex;
+  std::map<void*, LargePagesBlock>& largePagesBlocks = *new std::map<void*, LargePagesBlock>;
+
+  void* register_block(void* mem, size_t size, size_t pageSize, bool mapped) {
+
+    if (mem)
+    {
+        std::lock_guard<std::mutex> lk(largePagesMutex);
+        largePagesBlocks[mem] = { size, pageSize, mapped };
+    }
+    return mem;
+  }
+
+  LargePagesBlock unregister_block(void* mem) {
+
+    std::lock_guard<std::mutex> lk(largePagesMutex);
+    auto it = largePagesBlocks.find(mem);
+    LargePagesBlock block = it != largePagesBlocks.end() ? it->second : LargePagesBlock{ 0, 4096, false };
+    if (it != largePagesBlocks.end())
+        largePagesBlocks.erase(it);
+    return block;
+  }
+
+} // namespace
 
 #if defined(_WIN32)
 
@@ -1198,26 +1310,48 @@ static void* aligned_large_pages_alloc_windows(size_t allocSize) {
 
   CloseHandle(hProcessToken);
 
-  return mem;
+  return register_block(mem, allocSize, largePageSize, false);
 
   #endif
 }
 
-void* aligned_large_pages_alloc(size_t allocSize) {
+void* aligned_large_pages_alloc(size_t allocSize, size_t pageSize) {
 
   // Try to allocate large pages
-  void* mem = aligned_large_pages_alloc_windows(allocSize);
+  void* mem = pageSize != 4096 ? aligned_large_pages_alloc_windows(allocSize) : nullptr;
 
   // Fall back to regular, page aligned, allocation if necessary
   if (!mem)
-      mem = VirtualAlloc(NULL, allocSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+      mem = register_block(VirtualAlloc(NULL, allocSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE),
+                           allocSize, 4096, false);
 
   return mem;
 }
 
 #else
 
-void* aligned_large_pages_alloc(size_t allocSize) {
+void* aligned_large_pages_alloc(size_t allocSize, size_t pageSize) {
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+  // Explicit huge pages from the hugetlbfs pool. The page size is encoded
+  // as log2 in the mmap() flags, see MAP_HUGE_2MB and MAP_HUGE_1GB.
+  #ifndef MAP_HUGE_SHIFT
+  #define MAP_HUGE_SHIFT 26
+  #endif
+  if (pageSize > 4096)
+  {
+      int log2PageSize = 0;
+      while ((size_t(1) << log2PageSize) < pageSize)
+          ++log2PageSize;
+
+      size_t size = ((allocSize + pageSize - 1) / pageSize) * pageSize;
+      int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2PageSize << MAP_HUGE_SHIFT);
+      void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+      if (mem != MAP_FAILED)
+          return register_block(mem, size, pageSize, true);
+  }
+#endif
 
 #if defined(__linux__)
   constexpr size_t alignment = 2 * 1024 * 1024; // assumed 2MB page size
@@ -1229,9 +1363,13 @@ void* aligned_large_pages_alloc(size_t allocSize) {
   size_t size = ((allocSize + alignment - 1) / alignment) * alignment;
   void *mem = std_aligned_alloc(alignment, size);
 #if defined(MADV_HUGEPAGE)
-  madvise(mem, size, MADV_HUGEPAGE);
+  if (pageSize != 4096)
+  {
+      madvise(mem, size, MADV_HUGEPAGE);
+      return register_block(mem, size, 0, false);
+  }
 #endif
-  return mem;
+  return register_block(mem, size, 4096, false);
 }
 
 #endif
@@ -1243,6 +1381,8 @@ void* aligned_large_pages_alloc(size_t allocSize) {
 
 void aligned_large_pages_free(void* mem) {
 
+  unregister_block(mem);
+
   if (mem && !VirtualFree(mem, 0, MEM_RELEASE))
   {
       DWORD err = GetLastError();
@@ -1256,7 +1396,188 @@ void aligned_large_pages_free(void* mem) {
 #else
 
 void aligned_large_pages_free(void *mem) {
-  std_aligned_free(mem);
+
+  LargePagesBlock block = unregister_block(mem);
+
+  if (block.mapped)
+      munmap(mem, block.size);
+  else
+      std_aligned_free(mem);
+}
+
+#endif
+
+
+/// large_pages_info() returns a description of the pages obtained for a block
+/// allocated with aligned_large_pages_alloc(), e.g. for reporting purposes.
+
+std::string large_pages_info(void* mem) {
+
+  std::lock_guard<std::mutex> lk(largePagesMutex);
+  auto it = largePagesBlocks.find(mem);
+
+  if (it == largePagesBlocks.end())
+      return "unknown";
+
+  const LargePagesBlock& block = it->second;
+
+  return  block.pageSize == 0 ? "transparent huge pages"
+        : block.pageSize == 4096 ? "regular 4KB pages"
+        : format_bytes(block.pageSize, 0) + " pages" + (block.mapped ? " (hugetlbfs)" : "");
+}
+
+
+/// shared_memory_map() maps a named memory segment that can be shared with other
+/// processes on the same host. If the segment does not exist yet it is created
+/// with the requested size (zero filled by the OS) and 'created' is set. Otherwise
+/// the existing segment is mapped and 'size' is updated to its actual size.
+/// Returns nullptr on failure. The segment outlives the process on POSIX systems
+/// (see /dev/shm on Linux), so that later processes can reuse its content,
+/// until shared_memory_remove() is called.
+
+#if defined(_WIN32)
+
+void* shared_memory_map(const std::string& name, size_t& size, bool& created) {
+
+  std::string objectName = "Local\\" + name;
+  HANDLE hMap = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                   DWORD(uint64_t(size) >> 32), DWORD(size & 0xFFFFFFFF),
+                                   objectName.c_str());
+  if (!hMap)
+      return nullptr;
+
+  created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+  void* mem = MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  CloseHandle(hMap); // The view keeps the section alive
+
+  if (mem && !created)
+  {
+      MEMORY_BASIC_INFORMATION info;
+      if (VirtualQuery(mem, &info, sizeof(info)))
+          size = info.RegionSize;
+  }
+
+  return mem;
+}
+
+void shared_memory_unmap(void* mem, size_t) {
+
+  if (mem)
+      UnmapViewOfFile(mem);
+}
+
+void shared_memory_remove(const std::string&) {
+  // The section goes away with the last handle to it
+}
+
+uint64_t process_id() {
+  return GetCurrentProcessId();
+}
+
+bool process_alive(uint64_t pid) {
+
+  HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, DWORD(pid));
+  if (!hProcess)
+      return GetLastError() != ERROR_INVALID_PARAMETER;
+
+  bool alive = WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT;
+  CloseHandle(hProcess);
+  return alive;
+}
+
+#else
+
+void* shared_memory_map(const std::string& name, size_t& size, bool& created) {
+
+  std::string objectName = "/" + name;
+
+  int fd = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  created = fd != -1;
+
+  if (created)
+  {
+      if (ftruncate(fd, off_t(size)) == -1)
+      {
+          close(fd);
+          shm_unlink(objectName.c_str());
+          return nullptr;
+      }
+  }
+  else
+  {
+      fd = shm_open(objectName.c_str(), O_RDWR, 0600);
+      if (fd == -1)
+          return nullptr;
+
+      // The creator may still be sizing the segment
+      struct stat st;
+      for (int i = 0; i < 1000 && !fstat(fd, &st) && st.st_size == 0; ++i)
+          usleep(1000);
+
+      if (fstat(fd, &st) == -1 || st.st_size == 0)
+      {
+          close(fd);
+          return nullptr;
+      }
+      size = size_t(st.st_size);
+  }
+
+  void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // The mapping keeps the segment alive
+
+  return mem == MAP_FAILED ? nullptr : mem;
+}
+
+void shared_memory_unmap(void* mem, size_t size) {
+
+  if (mem)
+      munmap(mem, size);
+}
+
+void shared_memory_remove(const std::string& name) {
+
+  shm_unlink(("/" + name).c_str());
+}
+
+uint64_t process_id() {
+  return uint64_t(getpid());
+}
+
+bool process_alive(uint64_t pid) {
+  return kill(pid_t(pid), 0) == 0 || errno != ESRCH;
+}
+
+#endif
+
+
+/// instructions_retired() reads the number of instructions executed so far in
+/// user mode by the calling thread, from a hardware performance counter opened
+/// at the first call. Returns false if the OS provides no such counter (or if
+/// it is not allowed, see /proc/sys/kernel/perf_event_paranoid on Linux).
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+bool instructions_retired(uint64_t& count) {
+
+  thread_local int fd = [] {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }();
+
+  return fd != -1 && read(fd, &count, sizeof(count)) == sizeof(count);
+}
+
+#else
+
+bool instructions_retired(uint64_t&) {
+  return false;
 }
 
 #endif
@@ -1264,9 +1585,149 @@ void aligned_large_pages_free(void *mem) {
 
 namespace WinProcGroup {
 
-#ifndef _WIN32
+#if defined(__linux__) && !defined(__ANDROID__)
+
+namespace {
+
+  // Logical processor as described in /sys/devices/system/cpu
+  struct CpuInfo {
+    int cpu, node, l3, core, smt;
+  };
+
+  int read_sys_int(const string& path, int def) {
+
+    std::ifstream f(path);
+    int value;
+    return f >> value ? value : def;
+  }
 
-void bindThisThread(size_t) {}
+  // Returns the first cpu of a list like "0-3,8-11", or -1
+  int first_cpu(const string& path) {
+
+    std::ifstream f(path);
+    int cpu;
+    return f >> cpu ? cpu : -1;
+  }
+
+  std::vector<CpuInfo> read_topology() {
+
+    std::vector<CpuInfo> cpus;
+    cpu_set_t mask;
+
+    if (sched_getaffinity(0, sizeof(mask), &mask))
+        return cpus;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &mask))
+            continue;
+
+        string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        CpuInfo info = { cpu, 0, -1, cpu, 0 };
+
+        // Physical core, identified by its first logical processor
+        int sibling = first_cpu(dir + "/topology/thread_siblings_list");
+        info.core = sibling >= 0 ? sibling : cpu;
+
+        // L3 domain, identified by the first logical processor sharing it
+        for (int idx = 0; idx < 10; ++idx)
+        {
+            string cache = dir + "/cache/index" + std::to_string(idx);
+            if (read_sys_int(cache + "/level", 0) == 3)
+                info.l3 = first_cpu(cache + "/shared_cpu_list");
+        }
+
+        // NUMA node, the cpu directory holds a nodeN link
+        if (DIR* d = opendir(dir.c_str()))
+        {
+            while (struct dirent* e = readdir(d))
+                if (!strncmp(e->d_name, "node", 4) && isdigit(e->d_name[4]))
+                    info.node = atoi(e->d_name + 4);
+            closedir(d);
+        }
+
+        cpus.push_back(info);
+    }
+
+    // Rank of each logical processor among the SMT siblings of its core
+    for (CpuInfo& c : cpus)
+        for (const CpuInfo& o : cpus)
+            c.smt += o.core == c.core && o.cpu < c.cpu;
+
+    return cpus;
+  }
+
+  // Orders the logical processors in which threads are bound. Physical cores
+  // come first, SMT siblings only once all cores have a thread. Compact fills
+  // an L3 domain, then a NUMA node, before moving to the next one, while
+  // scatter puts consecutive threads on different L3 domains and nodes.
+  std::vector<int> cpu_order(const std::vector<CpuInfo>& cpus, BindMode mode) {
+
+    std::vector<std::pair<int, int>> domains; // (node, l3)
+    for (const CpuInfo& c : cpus)
+        if (std::find(domains.begin(), domains.end(), std::make_pair(c.node, c.l3)) == domains.end())
+            domains.emplace_back(c.node, c.l3);
+
+    auto domain_of = [&](const CpuInfo& c) {
+        return int(std::find(domains.begin(), domains.end(), std::make_pair(c.node, c.l3)) - domains.begin());
+    };
+
+    // Position of a domain within its node, and of a core within its domain
+    auto domain_rank = [&](int d) {
+        return int(std::count_if(domains.begin(), domains.begin() + d,
+                                 [&](const std::pair<int, int>& o) { return o.first == domains[d].first; }));
+    };
+    auto core_rank = [&](const CpuInfo& c) {
+        return int(std::count_if(cpus.begin(), cpus.end(), [&](const CpuInfo& o) {
+            return o.smt == c.smt && domain_of(o) == domain_of(c) && o.core < c.core; }));
+    };
+
+    std::vector<std::pair<std::vector<int>, int>> keys;
+    for (const CpuInfo& c : cpus)
+    {
+        int d = domain_of(c);
+        keys.emplace_back(mode == BindCompact ? std::vector<int>{ c.smt, c.node, d, c.core }
+                                              : std::vector<int>{ c.smt, core_rank(c), domain_rank(d), c.node },
+                          c.cpu);
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> order;
+    for (const auto& k : keys)
+        order.push_back(k.second);
+    return order;
+  }
+}
+
+
+/// bindThisThread() binds the current thread to a single logical processor,
+/// chosen according to the topology found in /sys/devices/system/cpu. If there
+/// are more threads than logical processors the OS is left to decide.
+
+void bindThisThread(size_t idx, BindMode mode) {
+
+  if (mode == BindNone)
+      return;
+
+  static const std::vector<CpuInfo> cpus = read_topology();
+  static const std::vector<int> orders[] = { {}, cpu_order(cpus, BindCompact), cpu_order(cpus, BindScatter) };
+
+  const std::vector<int>& order = orders[mode];
+
+  if (idx >= order.size())
+      return;
+
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  CPU_SET(order[idx], &mask);
+
+  pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+}
+
+#elif !defined(_WIN32)
+
+void bindThisThread(size_t, BindMode) {}
 
 #else
 
@@ -1341,9 +1802,13 @@ int best_group(size_t idx) {
 }
 
 
-/// bindThisThread() set the group affinity of the current thread
+/// bindThisThread() set the group affinity of the current thread. Groups are
+/// too coarse to tell compact and scatter binding apart.
+
+void bindThisThread(size_t idx, BindMode mode) {
 
-void bindThisThread(size_t idx) {
+  if (mode == BindNone)
+      return;
 
   // Use only local variables to be thread-safe
   int group = best_group(idx);
@@ -1361,10 +1826,7 @@ void bindThisThread(size_t idx) {
 
   GROUP_AFFINITY affinity;
   if (fun2(group, &affinity))
-  {
-	  sync_cout << "info string Binding thread " << idx << " to group " << group << sync_endl;
       fun3(GetCurrentThread(), &affinity, nullptr);
-  }
 }
 
 #endif
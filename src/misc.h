@@ -51,12 +51,33 @@ namespace SysInfo
     const std::string total_memory();
 }
 
+#if defined(USE_FAT_BINARY)
+/// CPU::has() tells whether the processor and the OS support an extension of
+/// the instruction set. A fat binary selects its code paths with it at startup.
+
+namespace CPU {
+
+enum Feature {
+  POPCNT, PEXT, SSSE3, SSE41, AVX2, AVX512, VNNI
+};
+
+bool has(Feature f);
+}
+#endif
+
 void prefetch(void* addr);
 void start_logger(const std::string& fname);
 void* std_aligned_alloc(size_t alignment, size_t size);
 void std_aligned_free(void* ptr);
-void* aligned_large_pages_alloc(size_t size); // memory aligned by page size, min alignment: 4096 bytes
+void* aligned_large_pages_alloc(size_t size, size_t pageSize = 0); // memory aligned by page size, min alignment: 4096 bytes
 void aligned_large_pages_free(void* mem); // nop if mem == nullptr
+std::string large_pages_info(void* mem); // describes the pages actually backing mem
+void* shared_memory_map(const std::string& name, size_t& size, bool& created); // named, inter-process
+void shared_memory_unmap(void* mem, size_t size); // nop if mem == nullptr
+void shared_memory_remove(const std::string& name); // mappings stay valid
+uint64_t process_id();
+bool process_alive(uint64_t pid); // true if unknown
+bool instructions_retired(uint64_t& count); // false without hardware counters
 
 void dbg_hit_on(bool b);
 void dbg_hit_on(bool c, bool b);
@@ -211,10 +232,12 @@ inline uint64_t mul_hi64(uint64_t a, uint64_t b) {
 /// logical processor group. This usually means to be limited to use max 64
 /// cores. To overcome this, some special platform specific API should be
 /// called to set group affinity for each thread. Original code from Texel by
-/// Peter Österlund.
+/// Peter Österlund. On Linux threads are bound to single logical processors
+/// following the core, cache and NUMA topology.
 
 namespace WinProcGroup {
-  void bindThisThread(size_t idx);
+  enum BindMode { BindNone, BindCompact, BindScatter };
+  void bindThisThread(size_t idx, BindMode mode);
 }
 
 namespace CommandLine {
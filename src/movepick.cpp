@@ -19,9 +19,14 @@
 #include <cassert>
 
 #include "movepick.h"
+#include "thread.h"
+#include "tt.h"
+#include "experience.h"
 
 namespace Stockfish {
 
+int MovePicker::PrefetchDistance = 2;
+
 namespace {
 
   enum Stages {
@@ -46,6 +51,25 @@ namespace {
         }
   }
 
+  // prefetch_child() preloads the memory that the search of the child position
+  // reached by move m will access first: its TT cluster, its experience bucket
+  // at main search nodes and, when pawns are involved, its pawn hash entry.
+  void prefetch_child(const Position& pos, Move m, bool mainSearch) {
+
+    if (!is_ok(m))
+        return;
+
+    Key key = pos.key_after(m);
+    prefetch(TT.first_entry(key));
+
+    if (mainSearch && Experience::enabled())
+        Experience::prefetch(key);
+
+    if (   type_of(pos.moved_piece(m)) == PAWN
+        || type_of(pos.piece_on(to_sq(m))) == PAWN)
+        prefetch(pos.this_thread()->pawnsTable[pos.pawn_key_after(m)]);
+  }
+
 } // namespace
 
 
@@ -125,6 +149,18 @@ void MovePicker::score() {
       }
 }
 
+/// MovePicker::prefetch_ahead() prefetches the child positions of the next
+/// PrefetchDistance moves of the current list starting at 'from', so that the memory latency is
+/// overlapped with the search of the move just returned. Only meaningful for
+/// lists that are returned in order, i.e. not for the Best picking stages.
+void MovePicker::prefetch_ahead(ExtMove* from) {
+
+  ExtMove* last = std::min(from + PrefetchDistance, endMoves);
+
+  for (endPrefetched = std::max(endPrefetched, from); endPrefetched < last; ++endPrefetched)
+      prefetch_child(pos, *endPrefetched, depth > 0);
+}
+
 /// MovePicker::select() returns the next move satisfying a predicate function.
 /// It never returns the TT move.
 template<MovePicker::PickType T, typename Pred>
@@ -136,7 +172,12 @@ Move MovePicker::select(Pred filter) {
           std::swap(*cur, *std::max_element(cur, endMoves));
 
       if (*cur != ttMove && filter())
+      {
+          if (T == Next)
+              prefetch_ahead(cur + 1);
+
           return *cur++;
+      }
 
       cur++;
   }
@@ -161,7 +202,7 @@ top:
   case CAPTURE_INIT:
   case PROBCUT_INIT:
   case QCAPTURE_INIT:
-      cur = endBadCaptures = moves;
+      cur = endBadCaptures = endPrefetched = moves;
       endMoves = generate<CAPTURES>(pos, cur);
 
       score<CAPTURES>();
@@ -176,7 +217,7 @@ top:
           return *(cur - 1);
 
       // Prepare the pointers to loop over the refutations array
-      cur = std::begin(refutations);
+      cur = endPrefetched = std::begin(refutations);
       endMoves = std::end(refutations);
 
       // If the countermove is the same as a killer, skip it
@@ -198,7 +239,7 @@ top:
   case QUIET_INIT:
       if (!skipQuiets)
       {
-          cur = endBadCaptures;
+          cur = endPrefetched = endBadCaptures;
           endMoves = generate<QUIETS>(pos, cur);
 
           score<QUIETS>();
@@ -216,7 +257,7 @@ top:
           return *(cur - 1);
 
       // Prepare the pointers to loop over the bad captures
-      cur = moves;
+      cur = endPrefetched = moves;
       endMoves = endBadCaptures;
 
       ++stage;
@@ -226,7 +267,7 @@ top:
       return select<Next>([](){ return true; });
 
   case EVASION_INIT:
-      cur = moves;
+      cur = endPrefetched = moves;
       endMoves = generate<EVASIONS>(pos, cur);
 
       score<EVASIONS>();
@@ -252,7 +293,7 @@ top:
       [[fallthrough]];
 
   case QCHECK_INIT:
-      cur = moves;
+      cur = endPrefetched = moves;
       endMoves = generate<QUIET_CHECKS>(pos, cur);
 
       ++stage;
@@ -137,9 +137,12 @@ public:
                                            int);
   Move next_move(bool skipQuiets = false);
 
+  static int PrefetchDistance; // Number of moves to prefetch ahead, 0 to disable
+
 private:
   template<PickType T, typename Pred> Move select(Pred);
   template<GenType> void score();
+  void prefetch_ahead(ExtMove* from);
   ExtMove* begin() { return cur; }
   ExtMove* end() { return endMoves; }
 
@@ -149,7 +152,7 @@ private:
   const CapturePieceToHistory* captureHistory;
   const PieceToHistory** continuationHistory;
   Move ttMove;
-  ExtMove refutations[3], *cur, *endMoves, *endBadCaptures;
+  ExtMove refutations[3], *cur, *endMoves, *endBadCaptures, *endPrefetched;
   int stage;
   Square recaptureSquare;
   Value threshold;
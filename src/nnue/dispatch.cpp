@@ -0,0 +1,99 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Selection of the NNUE code for the CPU in a fat binary
+
+#if defined(USE_FAT_BINARY)
+
+#include "../evaluate.h"
+#include "../misc.h"
+#include "../position.h"
+
+#include "evaluate_nnue.h"
+
+namespace Stockfish::Eval::NNUE {
+
+  // The builds of evaluate_nnue.cpp, see FATVARIANTS in the Makefile
+  extern "C" const Variant nnue_variant_sse2, nnue_variant_ssse3, nnue_variant_sse41,
+                           nnue_variant_avx2, nnue_variant_avx512, nnue_variant_vnni512;
+
+  namespace {
+
+  struct Selection {
+    const Variant& variant;
+    const char* instructionSets;
+  };
+
+  // Pick the build for the best instruction set of the CPU
+  Selection select() {
+
+    using namespace CPU;
+
+    return has(AVX512) && has(VNNI) ? Selection{ nnue_variant_vnni512, " VNNI AVX512 AVX2 SSE41 SSSE3" }
+         : has(AVX512)              ? Selection{ nnue_variant_avx512,  " AVX512 AVX2 SSE41 SSSE3" }
+         : has(AVX2)                ? Selection{ nnue_variant_avx2,    " AVX2 SSE41 SSSE3" }
+         : has(SSE41)               ? Selection{ nnue_variant_sse41,   " SSE41 SSSE3" }
+         : has(SSSE3)               ? Selection{ nnue_variant_ssse3,   " SSSE3" }
+                                    : Selection{ nnue_variant_sse2,    "" };
+  }
+
+  const Selection Selected = select();
+
+  } // namespace
+
+  Value evaluate(const Position& pos, bool adjusted) {
+    return Selected.variant.evaluate(pos, adjusted);
+  }
+
+  void evaluate(const Position* const positions[], std::size_t count, Value values[], bool adjusted) {
+    Selected.variant.evaluate_batch(positions, count, values, adjusted);
+  }
+
+  std::string trace(Position& pos) {
+    return Selected.variant.trace(pos);
+  }
+
+  bool load_eval(std::string name, std::istream& stream) {
+    return Selected.variant.load_eval(name, stream);
+  }
+
+  bool save_eval(std::ostream& stream, bool compressed) {
+    return Selected.variant.save_eval(stream, compressed);
+  }
+
+  bool save_eval(const std::optional<std::string>& filename, bool compressed) {
+    return Selected.variant.save_eval_file(filename, compressed);
+  }
+
+  bool share_eval(const std::string& segment, const std::string& name,
+                  std::uint64_t netSize, std::uint64_t netChecksum, const std::function<bool()>& load) {
+    return Selected.variant.share_eval(segment, name, netSize, netChecksum, load);
+  }
+
+  void benchmark(Position* const positions[], std::size_t count, int passes, std::ostream& os) {
+    Selected.variant.benchmark(positions, count, passes, os);
+  }
+
+  // The instruction sets of the selected build beyond SSE2, for compiler_info()
+  const char* instruction_sets() {
+    return Selected.instructionSets;
+  }
+
+} // namespace Stockfish::Eval::NNUE
+
+#endif
@@ -18,14 +18,24 @@
 
 // Code for calculating NNUE evaluation function
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "../evaluate.h"
+#include "../movegen.h"
 #include "../position.h"
+#include "../thread.h"
 #include "../misc.h"
 #include "../uci.h"
 #include "../types.h"
@@ -34,32 +44,95 @@
 
 namespace Stockfish::Eval::NNUE {
 
-  // Input feature converter
-  LargePagePtr<FeatureTransformer> featureTransformer;
+  // Parameters of the network as one block, already laid out for the SIMD code,
+  // so that the processes of a host can share a single copy, see share_eval()
+  struct Parameters {
+    FeatureTransformer featureTransformer;
+    Network network[LayerStacks];
+  };
+
+  static_assert(std::is_trivially_copyable_v<Parameters>);
+
+  // Parameters read by this process
+  LargePagePtr<Parameters> parameters;
 
-  // Evaluation function
-  AlignedPtr<Network> network[LayerStacks];
+  // Input feature converter in use, from the parameters of this process or
+  // from a shared segment
+  FeatureTransformer* featureTransformer;
+
+  // Evaluation function in use
+  Network* network[LayerStacks];
 
   // Evaluation function file name
   std::string fileName;
   std::string netDescription;
 
-  namespace Detail {
+  // Header of a shared segment, the parameters follow it. The magic is set by
+  // the process that created the segment once the parameters are filled in.
+  // The network is identified by the size and the checksum of its file.
+  struct alignas(4096) SharedHeader {
+    std::atomic<std::uint64_t> magic;
+    std::atomic<std::uint64_t> creator; // Process id
+    std::uint64_t layout;
+    std::uint64_t netSize;
+    std::uint64_t netChecksum;
+    char evalFile[256];
+    char description[4096 - 5 * sizeof(std::uint64_t) - 256];
+  };
 
-  // Initialize the evaluation function parameters
-  template <typename T>
-  void initialize(AlignedPtr<T>& pointer) {
+  constexpr std::uint64_t SharedMagic  = 0x53756741524E4E00ULL | 2; // "SugARNN", version 2
+  constexpr std::uint64_t SharedFailed = 0x53756741524E4E00ULL | 0xFF;
 
-    pointer.reset(reinterpret_cast<T*>(std_aligned_alloc(alignof(T), sizeof(T))));
-    std::memset(pointer.get(), 0, sizeof(T));
-  }
+  static_assert(sizeof(SharedHeader) == 4096, "Unexpected SharedHeader size");
+
+  // Instruction sets the weights are permuted for
+  constexpr std::uint64_t InstructionSets = 0
+#if defined(USE_NEON)
+      | 1 << 0
+#endif
+#if defined(USE_SSE2)
+      | 1 << 1
+#endif
+#if defined(USE_SSSE3)
+      | 1 << 2
+#endif
+#if defined(USE_SSE41)
+      | 1 << 3
+#endif
+#if defined(USE_AVX2)
+      | 1 << 4
+#endif
+#if defined(USE_AVX512)
+      | 1 << 5
+#endif
+#if defined(USE_VNNI)
+      | 1 << 6
+#endif
+      ;
 
+  // Memory layout of the parameters, segments filled in by another build of
+  // the network are not used.
+  constexpr std::uint64_t Layout =  std::uint64_t(HashValue) << 32
+                                  ^ InstructionSets << 24
+                                  ^ sizeof(Parameters);
+
+  // Shared segment holding the parameters in use, if any
+  void* sharedMem;
+  std::size_t sharedSize;
+
+  namespace Detail {
+
+  // Initialize the evaluation function parameters
   template <typename T>
   void initialize(LargePagePtr<T>& pointer) {
 
     static_assert(alignof(T) <= 4096, "aligned_large_pages_alloc() may fail for such a big alignment requirement of T");
-    pointer.reset(reinterpret_cast<T*>(aligned_large_pages_alloc(sizeof(T))));
+    const std::size_t pageSize = Options["Large Pages NNUE"] ? UCI::large_page_size() : 0;
+    pointer.reset(reinterpret_cast<T*>(aligned_large_pages_alloc(sizeof(T), pageSize)));
     std::memset(pointer.get(), 0, sizeof(T));
+
+    if (pageSize > 4096)
+        sync_cout << "info string NNUE weights allocated with " << large_pages_info(pointer.get()) << sync_endl;
   }
 
   // Read evaluation function parameters
@@ -73,21 +146,59 @@ namespace Stockfish::Eval::NNUE {
   }
 
   // Write evaluation function parameters
-  template <typename T>
-  bool write_parameters(std::ostream& stream, const T& reference) {
+  template <typename T, typename... Args>
+  bool write_parameters(std::ostream& stream, const T& reference, Args... args) {
 
     write_little_endian<std::uint32_t>(stream, T::get_hash_value());
-    return reference.write_parameters(stream);
+    return reference.write_parameters(stream, args...);
   }
 
   }  // namespace Detail
 
+  // Maximum number of positions propagated together by a batch evaluation
+  constexpr std::size_t BatchSize = 128;
+
+  // Buffers of a batch evaluation, too large for the stack
+  struct BatchBuffers {
+    alignas(CacheLineSize) TransformedFeatureType transformedFeatures[BatchSize * FeatureTransformer::BufferSize];
+    alignas(CacheLineSize) char buffer[BatchSize * Network::BufferSize];
+  };
+
+  // Final evaluation from the psqt and positional outputs of the network
+  inline Value blend(const Position& pos, int materialist, int positional, bool adjusted) {
+
+    int delta_npm = abs(pos.non_pawn_material(WHITE) - pos.non_pawn_material(BLACK));
+    int entertainment = (adjusted && delta_npm <= BishopValueMg - KnightValueMg ? 7 : 0);
+
+    int A = 128 - entertainment;
+    int B = 128 + entertainment;
+
+    int sum = (A * materialist + B * positional) / 128;
+
+    return static_cast<Value>( sum / OutputScale );
+  }
+
+  // Use the given parameters for the evaluation
+  void use(Parameters* p) {
+
+    featureTransformer = &p->featureTransformer;
+    for (std::size_t i = 0; i < LayerStacks; ++i)
+      network[i] = &p->network[i];
+  }
+
+  // Unmap the shared segment of the previous parameters, if any
+  void release_shared() {
+
+    shared_memory_unmap(sharedMem, sharedSize);
+    sharedMem = nullptr;
+  }
+
   // Initialize the evaluation function parameters
   void initialize() {
 
-    Detail::initialize(featureTransformer);
-    for (std::size_t i = 0; i < LayerStacks; ++i)
-      Detail::initialize(network[i]);
+    release_shared();
+    Detail::initialize(parameters);
+    use(parameters.get());
   }
 
   // Read network header
@@ -126,11 +237,11 @@ namespace Stockfish::Eval::NNUE {
     return stream && stream.peek() == std::ios::traits_type::eof();
   }
 
-  // Write network parameters
-  bool write_parameters(std::ostream& stream) {
+  // Write network parameters, the feature transformer compressed or not
+  bool write_parameters(std::ostream& stream, bool compressed) {
 
     if (!write_header(stream, HashValue, netDescription)) return false;
-    if (!Detail::write_parameters(stream, *featureTransformer)) return false;
+    if (!Detail::write_parameters(stream, *featureTransformer, compressed)) return false;
     for (std::size_t i = 0; i < LayerStacks; ++i)
       if (!Detail::write_parameters(stream, *(network[i]))) return false;
     return (bool)stream;
@@ -161,21 +272,242 @@ namespace Stockfish::Eval::NNUE {
     ASSERT_ALIGNED(buffer, alignment);
 
     const std::size_t bucket = (pos.count<ALL_PIECES>() - 1) / 4;
-    const auto psqt = featureTransformer->transform(pos, transformedFeatures, bucket);
+
+#if defined(USE_AVX2)
+    // The first hidden layer clips the accumulators itself
+    AccumulatorInput input = { {}, transformedFeatures };
+    const auto psqt = featureTransformer->transform(pos, pos.this_thread()->accumulatorCache, input, bucket);
+    const auto output = network[bucket]->propagate(input, buffer);
+#else
+    const auto psqt = featureTransformer->transform(pos, pos.this_thread()->accumulatorCache, transformedFeatures, bucket);
     const auto output = network[bucket]->propagate(transformedFeatures, buffer);
+#endif
 
-    int materialist = psqt;
-    int positional  = output[0];
+    return blend(pos, psqt, output[0], adjusted);
+  }
 
-    int delta_npm = abs(pos.non_pawn_material(WHITE) - pos.non_pawn_material(BLACK));
-    int entertainment = (adjusted && delta_npm <= BishopValueMg - KnightValueMg ? 7 : 0);
+  // Evaluation of a batch of positions. Their features are transformed into a
+  // contiguous buffer, ordered by layer stack, and each stack propagates its
+  // positions together. The results are those of evaluate() one at a time.
+  void evaluate(const Position* const positions[], std::size_t count, Value values[], bool adjusted) {
 
-    int A = 128 - entertainment;
-    int B = 128 + entertainment;
+    static_assert(FeatureTransformer::BufferSize == Layers::InputLayer::BatchStride);
 
-    int sum = (A * materialist + B * positional) / 128;
+    AlignedPtr<BatchBuffers> b(reinterpret_cast<BatchBuffers*>(
+        std_aligned_alloc(alignof(BatchBuffers), sizeof(BatchBuffers))));
 
-    return static_cast<Value>( sum / OutputScale );
+    for (std::size_t start = 0; start < count; start += BatchSize)
+    {
+        const std::size_t size = std::min(BatchSize, count - start);
+        const Position* const* batch = positions + start;
+
+        // Counting sort of the positions by bucket
+        std::size_t first[LayerStacks + 1] = {}, next[LayerStacks];
+        std::size_t order[BatchSize];
+        int psqt[BatchSize];
+
+        for (std::size_t i = 0; i < size; ++i)
+            ++first[(batch[i]->count<ALL_PIECES>() - 1) / 4 + 1];
+
+        for (std::size_t bucket = 0; bucket < LayerStacks; ++bucket)
+            next[bucket] = first[bucket + 1] += first[bucket];
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const Position& pos = *batch[i];
+            const std::size_t bucket = (pos.count<ALL_PIECES>() - 1) / 4;
+            const std::size_t slot = first[bucket]++;
+
+            order[slot] = i;
+            psqt[slot] = featureTransformer->transform(pos, pos.this_thread()->accumulatorCache,
+                                                       &b->transformedFeatures[slot * FeatureTransformer::BufferSize], bucket);
+        }
+
+        for (std::size_t bucket = 0, slot = 0; bucket < LayerStacks; slot = next[bucket++])
+        {
+            if (slot == next[bucket])
+                continue;
+
+            const auto output = reinterpret_cast<const char*>(network[bucket]->propagate(
+                &b->transformedFeatures[slot * FeatureTransformer::BufferSize], b->buffer, next[bucket] - slot));
+
+            for (std::size_t j = 0; slot + j < next[bucket]; ++j)
+            {
+                const std::size_t i = order[slot + j];
+                values[start + i] = blend(*batch[i], psqt[slot + j],
+                                          *reinterpret_cast<const Network::OutputType*>(output + j * Network::BatchStride), adjusted);
+            }
+        }
+    }
+  }
+
+  // Timing of the stages of the evaluation for benchmark(). With warm caches
+  // each call is repeated, with cold ones the CPU caches are evicted before
+  // each call by writing a buffer larger than them. The cost of reading the
+  // clock and the instruction counter is subtracted.
+  class Profiler {
+
+    struct Stage {
+      std::string name;
+      std::uint64_t calls, bytes, nanoseconds, instructions;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<Stage> stages;
+    std::vector<char> evictBuffer;
+    const int repeats;
+    bool counted;
+    std::int64_t clockCost = std::numeric_limits<std::int64_t>::max();
+    std::uint64_t counterCost = std::numeric_limits<std::uint64_t>::max();
+
+    template <typename F>
+    std::pair<std::int64_t, std::uint64_t> measure(F&& f, int n) {
+
+      std::uint64_t i0 = 0, i1 = 0;
+      counted = instructions_retired(i0);
+      const auto t0 = Clock::now();
+      for (int i = 0; i < n; ++i)
+      {
+          f();
+          std::atomic_signal_fence(std::memory_order_seq_cst); // Keep the calls apart
+      }
+      const auto t1 = Clock::now();
+      counted = counted && instructions_retired(i1);
+
+      return { std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count(), i1 - i0 };
+    }
+
+  public:
+    Profiler(int passes, bool cold) : repeats(cold ? 1 : passes) {
+
+      if (cold)
+          evictBuffer.resize(64 * 1024 * 1024);
+
+      for (int i = 0; i < 1000; ++i)
+      {
+          auto [ns, instructions] = measure([]() {}, 1);
+          clockCost = std::min(clockCost, ns);
+          counterCost = std::min(counterCost, instructions);
+      }
+    }
+
+    template <typename F>
+    void operator()(const std::string& name, std::size_t bytes, F&& f) {
+
+      auto it = std::find_if(stages.begin(), stages.end(), [&](const Stage& s) { return s.name == name; });
+      Stage& stage = it != stages.end() ? *it : stages.emplace_back(Stage{ name, 0, 0, 0, 0 });
+
+      for (std::size_t i = 0; i < evictBuffer.size(); i += CacheLineSize)
+          ++evictBuffer[i];
+
+      auto [ns, instructions] = measure(f, repeats);
+      stage.calls += repeats;
+      stage.bytes += repeats * bytes;
+      stage.nanoseconds += std::max(ns - clockCost, std::int64_t(0));
+      stage.instructions += instructions - std::min(instructions, counterCost);
+    }
+
+    // A layer of the network, named after its kind and dimensions
+    template <typename F>
+    void operator()(const char* kind, IndexType outputs, IndexType inputs, std::size_t bytes, F&& f) {
+      (*this)(std::string(kind) + "[" + std::to_string(outputs) + "<-" + std::to_string(inputs) + "]", bytes, f);
+    }
+
+    void report(std::ostream& os, const char* cache) const {
+
+      for (const Stage& s : stages)
+      {
+          double ns = double(s.nanoseconds) / s.calls;
+          os << s.name << "," << cache << "," << s.calls
+             << "," << std::fixed << std::setprecision(1) << ns
+             << "," << s.bytes / s.calls
+             << "," << std::setprecision(2) << (ns > 0 ? s.bytes / s.calls / ns : 0.0) << ",";
+          if (counted)
+              os << std::setprecision(1) << double(s.instructions) / s.calls;
+          else
+              os << "NA";
+          os << std::defaultfloat << "\n";
+      }
+    }
+  };
+
+  /// benchmark() times the stages of the evaluation of the given positions on
+  /// their own: the refresh of the accumulators from the king square cache, their
+  /// incremental update after a move, the conversion of the accumulators into the
+  /// input of the network, each layer of the network, and the whole evaluation of
+  /// an up to date accumulator, with the first layer clipping the accumulators
+  /// itself where it can, see AccumulatorInput. Every stage is run passes times
+  /// per position with warm caches, then once with cold caches. A CSV line per
+  /// stage and cache state reports the time and the instructions per call, and
+  /// the bytes of parameters and accumulators read by a call.
+  void benchmark(Position* const positions[], std::size_t count, int passes, std::ostream& os) {
+
+    alignas(CacheLineSize) TransformedFeatureType transformedFeatures[FeatureTransformer::BufferSize];
+    alignas(CacheLineSize) char buffer[Network::BufferSize];
+
+    // The weights of a feature, and an accumulator, for one perspective
+    constexpr std::size_t RowBytes =  TransformedFeatureDimensions * sizeof(std::int16_t)
+                                    + PSQTBuckets * sizeof(std::int32_t);
+    constexpr std::size_t AccumulatorBytes =  sizeof(Accumulator::accumulation[0])
+                                            + sizeof(Accumulator::psqtAccumulation[0]);
+
+    os << "stage,cache,calls,ns_per_call,bytes_per_call,gb_per_s,instructions_per_call\n";
+
+    for (bool cold : { false, true })
+    {
+        Profiler profiler(passes, cold);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Position& pos = *positions[i];
+            AccumulatorCache& cache = pos.this_thread()->accumulatorCache;
+            Accumulator& accumulator = *pos.state()->accumulator;
+            const int bucket = (pos.count<ALL_PIECES>() - 1) / 4;
+
+            profiler("refresh", 2 * pos.count<ALL_PIECES>() * RowBytes, [&]() {
+                accumulator.computed[WHITE] = accumulator.computed[BLACK] = false;
+                featureTransformer->update_accumulators(pos, cache);
+            });
+
+            // The first legal move that is not a king move, which would need a refresh
+            for (const auto& m : MoveList<LEGAL>(pos))
+                if (type_of(pos.moved_piece(m)) != KING)
+                {
+                    StateInfo st;
+                    pos.do_move(m, st);
+
+                    profiler("update", 2 * (2 * st.dirtyPiece.dirty_num * RowBytes + 2 * AccumulatorBytes), [&]() {
+                        st.accumulator->computed[WHITE] = st.accumulator->computed[BLACK] = false;
+                        featureTransformer->update_accumulators(pos, cache);
+                    });
+
+                    pos.undo_move(m);
+                    break;
+                }
+
+            profiler("transform", 2 * AccumulatorBytes + sizeof(transformedFeatures), [&]() {
+                featureTransformer->transform(pos, cache, transformedFeatures, bucket);
+            });
+
+            network[bucket]->profile(transformedFeatures, buffer, profiler);
+
+            profiler("evaluate", 2 * AccumulatorBytes + sizeof(Network), [&]() {
+                featureTransformer->transform(pos, cache, transformedFeatures, bucket);
+                network[bucket]->propagate(transformedFeatures, buffer);
+            });
+
+#if defined(USE_AVX2)
+            profiler("evaluate_fused", 2 * AccumulatorBytes + sizeof(Network), [&]() {
+                AccumulatorInput input = { {}, transformedFeatures };
+                featureTransformer->transform(pos, cache, input, bucket);
+                network[bucket]->propagate(input, buffer);
+            });
+#endif
+        }
+
+        profiler.report(os, cold ? "cold" : "warm");
+    }
   }
 
   struct NnueEvalTrace {
@@ -212,7 +544,7 @@ namespace Stockfish::Eval::NNUE {
     NnueEvalTrace t{};
     t.correctBucket = (pos.count<ALL_PIECES>() - 1) / 4;
     for (std::size_t bucket = 0; bucket < LayerStacks; ++bucket) {
-      const auto psqt = featureTransformer->transform(pos, transformedFeatures, bucket);
+      const auto psqt = featureTransformer->transform(pos, pos.this_thread()->accumulatorCache, transformedFeatures, bucket);
       const auto output = network[bucket]->propagate(transformedFeatures, buffer);
 
       int materialist = psqt;
@@ -315,16 +647,16 @@ namespace Stockfish::Eval::NNUE {
           auto st = pos.state();
 
           pos.remove_piece(sq);
-          st->accumulator.computed[WHITE] = false;
-          st->accumulator.computed[BLACK] = false;
+          st->accumulator->computed[WHITE] = false;
+          st->accumulator->computed[BLACK] = false;
 
           Value eval = evaluate(pos);
           eval = pos.side_to_move() == WHITE ? eval : -eval;
           v = base - eval;
 
           pos.put_piece(pc, sq);
-          st->accumulator.computed[WHITE] = false;
-          st->accumulator.computed[BLACK] = false;
+          st->accumulator->computed[WHITE] = false;
+          st->accumulator->computed[BLACK] = false;
         }
 
         writeSquare(f, r, pc, v);
@@ -378,16 +710,16 @@ namespace Stockfish::Eval::NNUE {
   }
 
   // Save eval, to a file stream or a memory stream
-  bool save_eval(std::ostream& stream) {
+  bool save_eval(std::ostream& stream, bool compressed) {
 
     if (fileName.empty())
       return false;
 
-    return write_parameters(stream);
+    return write_parameters(stream, compressed);
   }
 
   /// Save eval, to a file given by its name
-  bool save_eval(const std::optional<std::string>& filename) {
+  bool save_eval(const std::optional<std::string>& filename, bool compressed) {
 
     std::string actualFilename;
     std::string msg;
@@ -407,7 +739,7 @@ namespace Stockfish::Eval::NNUE {
     }
 
     std::ofstream stream(actualFilename, std::ios_base::binary);
-    bool saved = save_eval(stream);
+    bool saved = save_eval(stream, compressed);
 
     msg = saved ? "Network saved successfully to " + actualFilename
                 : "Failed to export a net";
@@ -416,5 +748,114 @@ namespace Stockfish::Eval::NNUE {
     return saved;
   }
 
+  /// share_eval() maps the named shared segment of the network parameters. The
+  /// process that creates it parses the network with the given load function
+  /// and copies the parameters into the segment, later processes use them as
+  /// they are if the size and checksum of their network file match, without
+  /// parsing it. Falls back to parameters of this process if the segment cannot
+  /// be used. Returns whether a network was loaded.
+  bool share_eval(const std::string& segment, const std::string& name,
+                  std::uint64_t netSize, std::uint64_t netChecksum, const std::function<bool()>& load) {
+
+    std::size_t size = sizeof(SharedHeader) + sizeof(Parameters);
+    bool created;
+
+    void* mem = shared_memory_map(segment, size, created);
+    if (!mem)
+    {
+        sync_cout << "info string Cannot map shared NNUE weights '" << segment
+                  << "', using private ones" << sync_endl;
+        return load();
+    }
+
+    SharedHeader* header = static_cast<SharedHeader*>(mem);
+    Parameters* shared = reinterpret_cast<Parameters*>(header + 1);
+
+    if (created)
+    {
+        header->creator.store(process_id(), std::memory_order_relaxed);
+
+        bool loaded = load();
+        bool fits =    name.size() < sizeof(header->evalFile)
+                    && netDescription.size() < sizeof(header->description);
+
+        // The OS hands out zeroed memory, so the strings are terminated
+        if (loaded && fits)
+        {
+            header->layout = Layout;
+            header->netSize = netSize;
+            header->netChecksum = netChecksum;
+            std::memcpy(header->evalFile, name.data(), name.size());
+            std::memcpy(header->description, netDescription.data(), netDescription.size());
+            std::memcpy(shared, parameters.get(), sizeof(Parameters));
+        }
+        header->magic.store(loaded && fits ? SharedMagic : SharedFailed, std::memory_order_release);
+
+        // Let a later process try again
+        if (!loaded || !fits)
+        {
+            shared_memory_unmap(mem, size);
+            shared_memory_remove(segment);
+            return loaded;
+        }
+    }
+    else
+    {
+        // The creator may still be parsing the network. If it died before
+        // publishing the parameters, the segment is created again.
+        for (int i = 0; i < 10000 && !header->magic.load(std::memory_order_acquire); ++i)
+        {
+            std::uint64_t creator = header->creator.load(std::memory_order_relaxed);
+            if (creator && !process_alive(creator) && !header->magic.load(std::memory_order_acquire))
+            {
+                shared_memory_unmap(mem, size);
+                shared_memory_remove(segment);
+                sync_cout << "info string Shared NNUE weights '" << segment
+                          << "' were abandoned, creating them again" << sync_endl;
+                return share_eval(segment, name, netSize, netChecksum, load);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (   header->magic.load(std::memory_order_acquire) != SharedMagic
+            || header->layout != Layout
+            || size < sizeof(SharedHeader) + sizeof(Parameters)
+            || header->netSize != netSize
+            || header->netChecksum != netChecksum)
+        {
+            shared_memory_unmap(mem, size);
+            sync_cout << "info string Shared NNUE weights '" << segment
+                      << "' are incompatible, using private ones" << sync_endl;
+            return load();
+        }
+
+        release_shared();
+        fileName = name;
+        netDescription = header->description;
+    }
+
+    // The private copy of a created segment is not needed any more
+    parameters.reset();
+    use(shared);
+    sharedMem = mem;
+    sharedSize = size;
+
+    sync_cout << "info string NNUE weights " << (created ? "created" : "joined")
+              << " as shared '" << segment << "'" << sync_endl;
+
+    return true;
+  }
+
+#if defined(NNUE_VARIANT)
+  #define variant_name2(v) nnue_variant_ ## v
+  #define variant_name(v) variant_name2(v)
+
+  // The entry points of this build, the only global symbol of its object file
+  extern "C" const Variant variant_name(NNUE_VARIANT);
+
+  const Variant variant_name(NNUE_VARIANT) = {
+    evaluate, evaluate, trace, load_eval, save_eval, save_eval, share_eval, benchmark
+  };
+#endif
 
 } // namespace Stockfish::Eval::NNUE
@@ -23,7 +23,10 @@
 
 #include "nnue_feature_transformer.h"
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 
 namespace Stockfish::Eval::NNUE {
 
@@ -54,6 +57,21 @@ namespace Stockfish::Eval::NNUE {
   template <typename T>
   using LargePagePtr = std::unique_ptr<T, LargePageDeleter<T>>;
 
+#if defined(USE_FAT_BINARY)
+  // Entry points of one of the builds of this code in a fat binary, each for
+  // an instruction set. The best one for the CPU is called, see dispatch.cpp.
+  struct Variant {
+    Value (*evaluate)(const Position&, bool);
+    void (*evaluate_batch)(const Position* const[], std::size_t, Value[], bool);
+    std::string (*trace)(Position&);
+    bool (*load_eval)(std::string, std::istream&);
+    bool (*save_eval)(std::ostream&, bool);
+    bool (*save_eval_file)(const std::optional<std::string>&, bool);
+    bool (*share_eval)(const std::string&, const std::string&, std::uint64_t, std::uint64_t, const std::function<bool()>&);
+    void (*benchmark)(Position* const[], std::size_t, int, std::ostream&);
+  };
+#endif
+
 }  // namespace Stockfish::Eval::NNUE
 
 #endif // #ifndef NNUE_EVALUATE_NNUE_H_INCLUDED
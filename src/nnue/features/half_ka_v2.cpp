@@ -70,6 +70,34 @@ namespace Stockfish::Eval::NNUE::Features {
     }
   }
 
+  // append_changed_indices() : get a list of indices for the features that
+  // differ between the position and the pieces of a cached accumulator
+
+  void HalfKAv2::append_changed_indices(
+    const Position& pos,
+    Color perspective,
+    const Bitboard byColorBB[COLOR_NB],
+    const Bitboard byTypeBB[PIECE_TYPE_NB],
+    ValueListInserter<IndexType> removed,
+    ValueListInserter<IndexType> added
+  ) {
+    Square ksq = orient(perspective, pos.square<KING>(perspective));
+    for (Color c : { WHITE, BLACK })
+      for (PieceType pt = PAWN; pt <= KING; ++pt)
+      {
+        Piece pc = make_piece(c, pt);
+        Bitboard oldBB = byColorBB[c] & byTypeBB[pt];
+        Bitboard newBB = pos.pieces(c, pt);
+        Bitboard toRemove = oldBB & ~newBB;
+        Bitboard toAdd = newBB & ~oldBB;
+
+        while (toRemove)
+          removed.push_back(make_index(perspective, pop_lsb(toRemove), pc, ksq));
+        while (toAdd)
+          added.push_back(make_index(perspective, pop_lsb(toAdd), pc, ksq));
+      }
+  }
+
   int HalfKAv2::update_cost(StateInfo* st) {
     return st->dirtyPiece.dirty_num;
   }
@@ -96,6 +96,16 @@ namespace Stockfish::Eval::NNUE::Features {
       ValueListInserter<IndexType> removed,
       ValueListInserter<IndexType> added);
 
+    // Get a list of indices for the features of the position that differ from
+    // those of the given pieces, with the king of the perspective on the same square
+    static void append_changed_indices(
+      const Position& pos,
+      Color perspective,
+      const Bitboard byColorBB[COLOR_NB],
+      const Bitboard byTypeBB[PIECE_TYPE_NB],
+      ValueListInserter<IndexType> removed,
+      ValueListInserter<IndexType> added);
+
     // Returns the cost of updating one perspective, the most costly one.
     // Assumes no refresh needed.
     static int update_cost(StateInfo* st);
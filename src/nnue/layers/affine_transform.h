@@ -21,6 +21,7 @@
 #ifndef NNUE_LAYERS_AFFINE_TRANSFORM_H_INCLUDED
 #define NNUE_LAYERS_AFFINE_TRANSFORM_H_INCLUDED
 
+#include <algorithm>
 #include <iostream>
 #include "../nnue_common.h"
 
@@ -51,6 +52,18 @@ namespace Stockfish::Eval::NNUE::Layers {
     static constexpr std::size_t SelfBufferSize =
         ceil_to_multiple(OutputDimensions * sizeof(OutputType), CacheLineSize);
 
+    // Distance in bytes between the outputs of a batch
+    static constexpr std::size_t BatchStride = SelfBufferSize;
+
+    // Number of inputs of a batch propagated together, their accumulators
+    // taking up to 8 registers
+#if defined (USE_SSSE3)
+    static constexpr IndexType BatchTile =
+        OutputDimensions % OutputSimdWidth == 0 ? std::max<IndexType>(1, 8 * OutputSimdWidth / OutputDimensions) : 1;
+#else
+    static constexpr IndexType BatchTile = 1;
+#endif
+
     // Size of the forward propagation buffer used from the input layer to this layer
     static constexpr std::size_t BufferSize =
         PreviousLayer::BufferSize + SelfBufferSize;
@@ -114,6 +127,49 @@ namespace Stockfish::Eval::NNUE::Layers {
         const TransformedFeatureType* transformedFeatures, char* buffer) const {
       const auto input = previousLayer.propagate(
           transformedFeatures, buffer + SelfBufferSize);
+      forward<1>(input, buffer);
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+    // Forward propagation from the accumulators, see AccumulatorInput
+    const OutputType* propagate(
+        const AccumulatorInput& accumulatorInput, char* buffer) const {
+      const auto input = previousLayer.propagate(
+          accumulatorInput, buffer + SelfBufferSize);
+      forward<1>(input, buffer);
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+    // Forward propagation of a batch of count inputs, BatchTile of them at a
+    // time so that they share the loads of the weights
+    const OutputType* propagate(
+        const TransformedFeatureType* transformedFeatures, char* buffer, IndexType count) const {
+      const auto input = previousLayer.propagate(
+          transformedFeatures, buffer + count * SelfBufferSize, count);
+      IndexType i = 0;
+      for ( ; i + BatchTile <= count; i += BatchTile)
+        forward<BatchTile>(input + i * PreviousLayer::BatchStride, buffer + i * SelfBufferSize);
+      for ( ; i < count; ++i)
+        forward<1>(input + i * PreviousLayer::BatchStride, buffer + i * SelfBufferSize);
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+    // Forward propagation timing each layer on its own, see NNUE::benchmark()
+    template <typename Profiler>
+    const OutputType* profile(
+        const TransformedFeatureType* transformedFeatures, char* buffer, Profiler& profiler) const {
+      const auto input = previousLayer.profile(
+          transformedFeatures, buffer + SelfBufferSize, profiler);
+      profiler("AffineTransform", OutputDimensions, InputDimensions,
+               sizeof(biases) + sizeof(weights), [&]() { forward<1>(input, buffer); });
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+   private:
+    // Propagates Tile inputs, PreviousLayer::BatchStride bytes apart, to the
+    // outputs, which are BatchStride bytes apart
+    template <IndexType Tile>
+    void forward(const InputType* input, char* buffer) const {
 
 #if defined (USE_AVX512)
 
@@ -250,6 +306,8 @@ namespace Stockfish::Eval::NNUE::Layers {
       auto& vec_hadd = m128_hadd;
 #endif
 
+      static_assert(Tile == 1 || Tile == BatchTile);
+
 #if defined (USE_SSSE3)
       const auto output = reinterpret_cast<OutputType*>(buffer);
       const auto inputVector = reinterpret_cast<const vec_t*>(input);
@@ -265,29 +323,39 @@ namespace Stockfish::Eval::NNUE::Layers {
           constexpr IndexType NumChunks = InputDimensions / 4;
           constexpr IndexType NumRegs = OutputDimensions / OutputSimdWidth;
 
-          const auto input32 = reinterpret_cast<const std::int32_t*>(input);
+          const std::int32_t* input32[Tile];
           const vec_t* biasvec = reinterpret_cast<const vec_t*>(biases);
-          vec_t outs[NumRegs];
-          for (IndexType k = 0; k < NumRegs; ++k)
-              outs[k] = biasvec[k];
+          vec_t outs[Tile][NumRegs];
+          for (IndexType t = 0; t < Tile; ++t)
+          {
+              input32[t] = reinterpret_cast<const std::int32_t*>(input + t * PreviousLayer::BatchStride);
+              for (IndexType k = 0; k < NumRegs; ++k)
+                  outs[t][k] = biasvec[k];
+          }
 
           for (IndexType i = 0; i < NumChunks; i += 4)
           {
-              const vec_t in0 = vec_set_32(input32[i + 0]);
-              const vec_t in1 = vec_set_32(input32[i + 1]);
-              const vec_t in2 = vec_set_32(input32[i + 2]);
-              const vec_t in3 = vec_set_32(input32[i + 3]);
               const auto col0 = reinterpret_cast<const vec_t*>(&weights[(i + 0) * OutputDimensions * 4]);
               const auto col1 = reinterpret_cast<const vec_t*>(&weights[(i + 1) * OutputDimensions * 4]);
               const auto col2 = reinterpret_cast<const vec_t*>(&weights[(i + 2) * OutputDimensions * 4]);
               const auto col3 = reinterpret_cast<const vec_t*>(&weights[(i + 3) * OutputDimensions * 4]);
-              for (IndexType k = 0; k < NumRegs; ++k)
-                  vec_add_dpbusd_32x4(outs[k], in0, col0[k], in1, col1[k], in2, col2[k], in3, col3[k]);
+              for (IndexType t = 0; t < Tile; ++t)
+              {
+                  const vec_t in0 = vec_set_32(input32[t][i + 0]);
+                  const vec_t in1 = vec_set_32(input32[t][i + 1]);
+                  const vec_t in2 = vec_set_32(input32[t][i + 2]);
+                  const vec_t in3 = vec_set_32(input32[t][i + 3]);
+                  for (IndexType k = 0; k < NumRegs; ++k)
+                      vec_add_dpbusd_32x4(outs[t][k], in0, col0[k], in1, col1[k], in2, col2[k], in3, col3[k]);
+              }
           }
 
-          vec_t* outptr = reinterpret_cast<vec_t*>(output);
-          for (IndexType k = 0; k < NumRegs; ++k)
-              outptr[k] = outs[k];
+          for (IndexType t = 0; t < Tile; ++t)
+          {
+              vec_t* outptr = reinterpret_cast<vec_t*>(buffer + t * SelfBufferSize);
+              for (IndexType k = 0; k < NumRegs; ++k)
+                  outptr[k] = outs[t][k];
+          }
       }
       else if constexpr (OutputDimensions == 1)
       {
@@ -424,11 +492,8 @@ namespace Stockfish::Eval::NNUE::Layers {
 #endif
 
 #endif
-
-      return output;
     }
 
-   private:
     using BiasType = OutputType;
     using WeightType = std::int8_t;
 
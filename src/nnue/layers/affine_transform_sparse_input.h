@@ -0,0 +1,553 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Definition of layer AffineTransformSparseInput of NNUE evaluation function
+
+#ifndef NNUE_LAYERS_AFFINE_TRANSFORM_SPARSE_INPUT_H_INCLUDED
+#define NNUE_LAYERS_AFFINE_TRANSFORM_SPARSE_INPUT_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include "../nnue_common.h"
+#include "../../bitboard.h"
+#include "affine_transform.h"
+#include "input_slice.h"
+
+/*
+  This layer computes the same function as AffineTransform, but its input is
+  mostly zero: the clipped output of the feature transformer. The inputs are
+  taken by chunks of 4 bytes and only the columns of the weights of the non-zero
+  chunks are accumulated. The weights are stored column by column, the 4 weights
+  of a chunk for an output being contiguous, so that a column is a few vectors.
+  When too many chunks are non-zero, all of them are accumulated in order, as
+  AffineTransform does with the same layout of the weights.
+*/
+
+namespace Stockfish::Eval::NNUE::Layers {
+
+#if defined (USE_AVX2)
+  // For each byte, the positions of its set bits followed by zeros
+  alignas(CacheLineSize) inline constexpr auto NonZeroIndices = [](){
+      std::array<std::array<std::uint16_t, 8>, 256> v{};
+      for (int i = 0; i < 256; ++i)
+          for (int j = 0, k = 0; j < 8; ++j)
+              if (i & (1 << j))
+                  v[i][k++] = j;
+      return v;
+  }();
+#endif
+
+  // Sparse input affine transformation layer
+  template <typename PreviousLayer, IndexType OutDims>
+  class AffineTransformSparseInput {
+   public:
+    // Input/output type
+    using InputType = typename PreviousLayer::OutputType;
+    using OutputType = std::int32_t;
+    static_assert(std::is_same<InputType, std::uint8_t>::value, "");
+
+    // Number of input/output dimensions
+    static constexpr IndexType InputDimensions =
+        PreviousLayer::OutputDimensions;
+    static constexpr IndexType OutputDimensions = OutDims;
+    static constexpr IndexType PaddedInputDimensions =
+        ceil_to_multiple<IndexType>(InputDimensions, MaxSimdWidth);
+
+    // Number of chunks of 4 inputs
+    static constexpr IndexType NumChunks = PaddedInputDimensions / 4;
+
+#if defined (USE_AVX512)
+    // Number of chunks in a mask of the non-zero chunks, one per SIMD vector
+    static constexpr IndexType MaskChunks = 16;
+#elif defined (USE_AVX2)
+    static constexpr IndexType MaskChunks = 8;
+#endif
+
+#if defined (USE_AVX2)
+    static constexpr IndexType NumMasks = NumChunks / MaskChunks;
+    static_assert(NumChunks % MaskChunks == 0);
+#endif
+
+#if defined (USE_AVX512)
+    static constexpr const IndexType OutputSimdWidth = SimdWidth / 2;
+#elif defined (USE_AVX2)
+    static constexpr const IndexType OutputSimdWidth = SimdWidth / 4;
+#endif
+
+#if defined (USE_AVX2)
+    static_assert(OutputDimensions % OutputSimdWidth == 0, "");
+#elif defined (USE_NEON)
+    static_assert(OutputDimensions % 2 == 0, "");
+#endif
+
+    // Size of forward propagation buffer used in this layer
+    static constexpr std::size_t SelfBufferSize =
+        ceil_to_multiple(OutputDimensions * sizeof(OutputType), CacheLineSize);
+
+    // Distance in bytes between the outputs of a batch
+    static constexpr std::size_t BatchStride = SelfBufferSize;
+
+    // Size of the forward propagation buffer used from the input layer to this layer
+    static constexpr std::size_t BufferSize =
+        PreviousLayer::BufferSize + SelfBufferSize;
+
+    // Hash value embedded in the evaluation file, the same as AffineTransform
+    static constexpr std::uint32_t get_hash_value() {
+      return AffineTransform<PreviousLayer, OutDims>::get_hash_value();
+    }
+
+    // Read network parameters
+    bool read_parameters(std::istream& stream) {
+      if (!previousLayer.read_parameters(stream)) return false;
+      for (std::size_t i = 0; i < OutputDimensions; ++i)
+        biases[i] = read_little_endian<BiasType>(stream);
+      for (std::size_t i = 0; i < OutputDimensions * PaddedInputDimensions; ++i)
+        weights[get_weight_index(i)] = read_little_endian<WeightType>(stream);
+
+      return !stream.fail();
+    }
+
+    // Write network parameters
+    bool write_parameters(std::ostream& stream) const {
+      if (!previousLayer.write_parameters(stream)) return false;
+      for (std::size_t i = 0; i < OutputDimensions; ++i)
+        write_little_endian<BiasType>(stream, biases[i]);
+      for (std::size_t i = 0; i < OutputDimensions * PaddedInputDimensions; ++i)
+        write_little_endian<WeightType>(stream, weights[get_weight_index(i)]);
+
+      return !stream.fail();
+    }
+
+    // Forward propagation
+    const OutputType* propagate(
+        const TransformedFeatureType* transformedFeatures, char* buffer) const {
+      const auto input = previousLayer.propagate(
+          transformedFeatures, buffer + SelfBufferSize);
+      forward(input, buffer);
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+#if defined (USE_AVX2)
+    // Forward propagation from the accumulators, see AccumulatorInput. The
+    // previous layer is the input slice of all the transformed features.
+    const OutputType* propagate(const AccumulatorInput& input, char* buffer) const {
+      static_assert(std::is_same_v<PreviousLayer, InputSlice<InputDimensions>>);
+      forward(input, buffer);
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+#endif
+
+    // Forward propagation of a batch of count inputs
+    const OutputType* propagate(
+        const TransformedFeatureType* transformedFeatures, char* buffer, IndexType count) const {
+      const auto input = previousLayer.propagate(
+          transformedFeatures, buffer + count * SelfBufferSize, count);
+      for (IndexType i = 0; i < count; ++i)
+        forward(input + i * PreviousLayer::BatchStride, buffer + i * SelfBufferSize);
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+    // Forward propagation timing each layer on its own, see NNUE::benchmark()
+    template <typename Profiler>
+    const OutputType* profile(
+        const TransformedFeatureType* transformedFeatures, char* buffer, Profiler& profiler) const {
+      const auto input = previousLayer.profile(
+          transformedFeatures, buffer + SelfBufferSize, profiler);
+      profiler("AffineTransformSparseInput", OutputDimensions, InputDimensions,
+               sizeof(biases) + sizeof(weights), [&]() { forward(input, buffer); });
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+   private:
+    // Position of the i-th weight of the file, which are stored row by row
+    static constexpr std::size_t get_weight_index(std::size_t i) {
+      return (i % PaddedInputDimensions) / 4 * OutputDimensions * 4
+            + i / PaddedInputDimensions * 4
+            + i % 4;
+    }
+
+    // Writes the indices of the non-zero chunks of the input to nnz and returns
+    // their number. When more than a third of the chunks are non-zero, the dense
+    // propagation is faster and NumChunks is returned without writing them.
+    static IndexType find_nnz(const std::int32_t* input, std::uint16_t* nnz) {
+
+      IndexType count = 0;
+
+#if defined (USE_AVX2)
+
+#if defined (USE_AVX512)
+      auto nnz_mask = [](const std::int32_t* in) -> unsigned {
+        return _mm512_cmpneq_epi32_mask(_mm512_load_si512(in), _mm512_setzero_si512());
+      };
+#else
+      auto nnz_mask = [](const std::int32_t* in) -> unsigned {
+        const __m256i zeros = _mm256_cmpeq_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(in)), _mm256_setzero_si256());
+        return ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(zeros))) & 0xFF;
+      };
+#endif
+
+      unsigned masks[NumMasks];
+
+      for (IndexType m = 0; m < NumMasks; ++m)
+          count += popcount(masks[m] = nnz_mask(input + m * MaskChunks));
+
+      if (count > NumChunks / 3)
+          return NumChunks;
+
+      return nnz_indices(masks, nnz);
+
+#else
+
+      for (IndexType i = 0; i < NumChunks; ++i)
+          count += input[i] != 0;
+
+      if (count > NumChunks / 3)
+          return NumChunks;
+
+      count = 0;
+
+      for (IndexType i = 0; i < NumChunks; ++i)
+          if (input[i])
+              nnz[count++] = std::uint16_t(i);
+
+      return count;
+
+#endif
+    }
+
+#if defined (USE_AVX2)
+    // Writes the indices of the non-zero chunks, given by the masks of MaskChunks
+    // chunks each, to nnz and returns their number. The indices of up to 8 bits
+    // of a mask are written at once, the next ones overwriting those past the
+    // last set bit.
+    static IndexType nnz_indices(const unsigned* masks, std::uint16_t* nnz) {
+
+      constexpr IndexType MaskBits = std::min<IndexType>(MaskChunks, 8);
+      const __m128i Increment = _mm_set1_epi16(MaskBits);
+      __m128i base = _mm_setzero_si128();
+      IndexType count = 0;
+
+      for (IndexType m = 0; m < NumMasks; ++m)
+      {
+          const unsigned mask = masks[m];
+
+          for (IndexType j = 0; j < MaskChunks; j += MaskBits)
+          {
+              const unsigned byte = (mask >> j) & ((1 << MaskBits) - 1);
+              const __m128i offsets = _mm_load_si128(reinterpret_cast<const __m128i*>(&NonZeroIndices[byte]));
+              _mm_storeu_si128(reinterpret_cast<__m128i*>(nnz + count), _mm_add_epi16(base, offsets));
+              count += popcount(byte);
+              base = _mm_add_epi16(base, Increment);
+          }
+      }
+
+      return count;
+    }
+#endif
+
+#if defined (USE_AVX2)
+    // Clips the accumulators into the transformed features, as
+    // FeatureTransformer::transform() does, and propagates them. The masks of
+    // the non-zero chunks are taken from the clipped vectors still in registers,
+    // instead of reading the whole input back as find_nnz() does.
+    void forward(const AccumulatorInput& input, char* buffer) const {
+
+      constexpr IndexType HalfDimensions = InputDimensions / 2;
+      constexpr IndexType MasksPerSide = NumMasks / 2;
+      static_assert(PaddedInputDimensions == InputDimensions);
+      static_assert(HalfDimensions == MasksPerSide * MaskChunks * 4);
+
+#if defined (USE_AVX512)
+      using vec_t = __m512i;
+      const __m512i Control = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+      const __m512i Zero = _mm512_setzero_si512();
+      auto clip = [&](vec_t sum0, vec_t sum1) {
+        return _mm512_permutexvar_epi64(Control, _mm512_max_epi8(_mm512_packs_epi16(sum0, sum1), Zero));
+      };
+      auto nnz_mask = [&](vec_t v) -> unsigned {
+        return _mm512_cmpneq_epi32_mask(v, Zero);
+      };
+#else
+      using vec_t = __m256i;
+      constexpr int Control = 0b11011000;
+      const __m256i Zero = _mm256_setzero_si256();
+      auto clip = [&](vec_t sum0, vec_t sum1) {
+        return _mm256_permute4x64_epi64(_mm256_max_epi8(_mm256_packs_epi16(sum0, sum1), Zero), Control);
+      };
+      auto nnz_mask = [&](vec_t v) -> unsigned {
+        return ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, Zero)))) & 0xFF;
+      };
+#endif
+
+      unsigned masks[NumMasks];
+      IndexType count = 0;
+
+      for (IndexType p = 0; p < 2; ++p)
+      {
+          const auto in = reinterpret_cast<const vec_t*>(input.accumulation[p]);
+          const auto out = reinterpret_cast<vec_t*>(input.transformedFeatures + HalfDimensions * p);
+
+          for (IndexType j = 0; j < MasksPerSide; ++j)
+          {
+              const vec_t clipped = clip(in[j * 2 + 0], in[j * 2 + 1]);
+              out[j] = clipped;
+              count += popcount(masks[p * MasksPerSide + j] = nnz_mask(clipped));
+          }
+      }
+
+      // Room for the 8 indices written at once by nnz_indices()
+      std::uint16_t nnz[NumChunks + 8];
+
+      affine(reinterpret_cast<const std::int32_t*>(input.transformedFeatures), nnz,
+             count > NumChunks / 3 ? NumChunks : nnz_indices(masks, nnz),
+             reinterpret_cast<OutputType*>(buffer));
+
+      assert(is_dense_output(reinterpret_cast<const std::int32_t*>(input.transformedFeatures),
+                             reinterpret_cast<const OutputType*>(buffer)));
+    }
+#endif
+
+    void forward(const InputType* input, char* buffer) const {
+
+      const auto input32 = reinterpret_cast<const std::int32_t*>(input);
+
+      // Room for the 8 indices written at once by nnz_indices()
+      std::uint16_t nnz[NumChunks + 8];
+
+      affine(input32, nnz, find_nnz(input32, nnz), reinterpret_cast<OutputType*>(buffer));
+
+      assert(is_dense_output(input32, reinterpret_cast<const OutputType*>(buffer)));
+    }
+
+#if !defined(NDEBUG)
+    // Checks that the output, propagated from the non-zero chunks only, is the
+    // same as the output of the propagation of all the chunks
+    bool is_dense_output(const std::int32_t* input32, const OutputType* output) const {
+
+      alignas(CacheLineSize) OutputType dense[OutputDimensions];
+      affine(input32, nullptr, NumChunks, dense);
+      return std::equal(dense, dense + OutputDimensions, output);
+    }
+#endif
+
+    // Accumulates the columns of the count non-zero chunks listed in nnz, or of
+    // all the chunks if count is NumChunks
+    void affine(const std::int32_t* input32, const std::uint16_t* nnz, IndexType count, OutputType* output) const {
+
+#if defined (USE_AVX2)
+
+#if defined (USE_AVX512)
+      using vec_t = __m512i;
+      auto vec_broadcast_32 = [](int a) { return _mm512_set1_epi32(a); };
+  #if defined (USE_VNNI)
+      auto vec_add_dpbusd_32 = [](vec_t& acc, vec_t a, vec_t b) {
+        acc = _mm512_dpbusd_epi32(acc, a, b);
+      };
+      // The 4 products are independent, only the last addition depends on acc
+      auto vec_add_dpbusd_32x4 = [](vec_t& acc, vec_t a0, vec_t b0, vec_t a1, vec_t b1,
+                                                vec_t a2, vec_t b2, vec_t a3, vec_t b3) {
+        const vec_t Zero = _mm512_setzero_si512();
+        const vec_t sum01 = _mm512_add_epi32(_mm512_dpbusd_epi32(Zero, a0, b0), _mm512_dpbusd_epi32(Zero, a1, b1));
+        const vec_t sum23 = _mm512_add_epi32(_mm512_dpbusd_epi32(Zero, a2, b2), _mm512_dpbusd_epi32(Zero, a3, b3));
+        acc = _mm512_add_epi32(acc, _mm512_add_epi32(sum01, sum23));
+      };
+  #else
+      auto vec_add_dpbusd_32 = [](vec_t& acc, vec_t a, vec_t b) {
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_maddubs_epi16(a, b), _mm512_set1_epi16(1)));
+      };
+      auto vec_add_dpbusd_32x4 = [](vec_t& acc, vec_t a0, vec_t b0, vec_t a1, vec_t b1,
+                                                vec_t a2, vec_t b2, vec_t a3, vec_t b3) {
+        const vec_t product0 = _mm512_adds_epi16(_mm512_maddubs_epi16(a0, b0), _mm512_maddubs_epi16(a1, b1));
+        const vec_t product2 = _mm512_adds_epi16(_mm512_maddubs_epi16(a2, b2), _mm512_maddubs_epi16(a3, b3));
+        acc = _mm512_add_epi32(acc, _mm512_add_epi32(_mm512_madd_epi16(product0, _mm512_set1_epi16(1)),
+                                                     _mm512_madd_epi16(product2, _mm512_set1_epi16(1))));
+      };
+  #endif
+#else
+      using vec_t = __m256i;
+      auto vec_broadcast_32 = [](int a) { return _mm256_set1_epi32(a); };
+  #if defined (USE_VNNI)
+      auto vec_add_dpbusd_32 = [](vec_t& acc, vec_t a, vec_t b) {
+        acc = _mm256_dpbusd_epi32(acc, a, b);
+      };
+      // The 4 products are independent, only the last addition depends on acc
+      auto vec_add_dpbusd_32x4 = [](vec_t& acc, vec_t a0, vec_t b0, vec_t a1, vec_t b1,
+                                                vec_t a2, vec_t b2, vec_t a3, vec_t b3) {
+        const vec_t Zero = _mm256_setzero_si256();
+        const vec_t sum01 = _mm256_add_epi32(_mm256_dpbusd_epi32(Zero, a0, b0), _mm256_dpbusd_epi32(Zero, a1, b1));
+        const vec_t sum23 = _mm256_add_epi32(_mm256_dpbusd_epi32(Zero, a2, b2), _mm256_dpbusd_epi32(Zero, a3, b3));
+        acc = _mm256_add_epi32(acc, _mm256_add_epi32(sum01, sum23));
+      };
+  #else
+      auto vec_add_dpbusd_32 = [](vec_t& acc, vec_t a, vec_t b) {
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(a, b), _mm256_set1_epi16(1)));
+      };
+      auto vec_add_dpbusd_32x4 = [](vec_t& acc, vec_t a0, vec_t b0, vec_t a1, vec_t b1,
+                                                vec_t a2, vec_t b2, vec_t a3, vec_t b3) {
+        const vec_t product0 = _mm256_adds_epi16(_mm256_maddubs_epi16(a0, b0), _mm256_maddubs_epi16(a1, b1));
+        const vec_t product2 = _mm256_adds_epi16(_mm256_maddubs_epi16(a2, b2), _mm256_maddubs_epi16(a3, b3));
+        acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_madd_epi16(product0, _mm256_set1_epi16(1)),
+                                                     _mm256_madd_epi16(product2, _mm256_set1_epi16(1))));
+      };
+  #endif
+#endif
+
+      constexpr IndexType NumRegs = OutputDimensions / OutputSimdWidth;
+
+      auto column = [&](IndexType i) {
+        return reinterpret_cast<const vec_t*>(&weights[i * OutputDimensions * 4]);
+      };
+
+      // The chunks are taken 4 at a time, as the dense kernel does. Without VNNI
+      // the products of the chunks j and j + 1 are added as 16-bit integers with
+      // saturation, so the result is the same only if the chunks are paired alike.
+      auto accumulate = [&](auto chunk, IndexType n) {
+        const auto biasvec = reinterpret_cast<const vec_t*>(biases);
+        vec_t acc[NumRegs];
+        for (IndexType k = 0; k < NumRegs; ++k)
+            acc[k] = biasvec[k];
+
+        IndexType j = 0;
+        for ( ; j + 3 < n; j += 4)
+        {
+            const vec_t in0 = vec_broadcast_32(input32[chunk(j + 0)]);
+            const vec_t in1 = vec_broadcast_32(input32[chunk(j + 1)]);
+            const vec_t in2 = vec_broadcast_32(input32[chunk(j + 2)]);
+            const vec_t in3 = vec_broadcast_32(input32[chunk(j + 3)]);
+            const vec_t* col0 = column(chunk(j + 0));
+            const vec_t* col1 = column(chunk(j + 1));
+            const vec_t* col2 = column(chunk(j + 2));
+            const vec_t* col3 = column(chunk(j + 3));
+            for (IndexType k = 0; k < NumRegs; ++k)
+                vec_add_dpbusd_32x4(acc[k], in0, col0[k], in1, col1[k], in2, col2[k], in3, col3[k]);
+        }
+        if (j + 1 < n)
+        {
+            // The last pair, with zero products for the missing chunks
+            const vec_t Zero = vec_broadcast_32(0);
+            const vec_t in0 = vec_broadcast_32(input32[chunk(j + 0)]);
+            const vec_t in1 = vec_broadcast_32(input32[chunk(j + 1)]);
+            const vec_t* col0 = column(chunk(j + 0));
+            const vec_t* col1 = column(chunk(j + 1));
+            for (IndexType k = 0; k < NumRegs; ++k)
+                vec_add_dpbusd_32x4(acc[k], in0, col0[k], in1, col1[k], Zero, col0[k], Zero, col1[k]);
+            j += 2;
+        }
+        for ( ; j < n; ++j)
+        {
+            const vec_t in = vec_broadcast_32(input32[chunk(j)]);
+            const vec_t* col = column(chunk(j));
+            for (IndexType k = 0; k < NumRegs; ++k)
+                vec_add_dpbusd_32(acc[k], in, col[k]);
+        }
+
+        const auto outptr = reinterpret_cast<vec_t*>(output);
+        for (IndexType k = 0; k < NumRegs; ++k)
+            outptr[k] = acc[k];
+      };
+
+      if (count == NumChunks)
+          accumulate([](IndexType j) { return j; }, NumChunks);
+      else
+      {
+#if defined (USE_VNNI)
+          accumulate([&](IndexType j) { return IndexType(nnz[j]); }, count);
+#else
+          // The non-zero chunks are taken with the other chunk of their pair,
+          // chunk 2p with chunk 2p + 1, whose products are zero if it is zero
+          std::uint16_t pairs[NumChunks / 2];
+          IndexType numPairs = 0;
+
+          for (IndexType j = 0; j < count; ++j)
+              if (!numPairs || pairs[numPairs - 1] != nnz[j] / 2)
+                  pairs[numPairs++] = nnz[j] / 2;
+
+          accumulate([&](IndexType j) { return IndexType(pairs[j / 2] * 2 + j % 2); }, numPairs * 2);
+#endif
+      }
+
+#elif defined (USE_NEON)
+
+      // The weights of two outputs are multiplied by a chunk duplicated, and
+      // the products of two chunks, at most 2 * 127 * 128 in absolute value,
+      // are added as 16-bit integers before the pairwise accumulation.
+      constexpr IndexType NumRegs = OutputDimensions / 2;
+
+      auto column = [&](IndexType i) {
+        return reinterpret_cast<const int8x8_t*>(&weights[i * OutputDimensions * 4]);
+      };
+
+      auto duplicate = [&](IndexType i) {
+        return vreinterpret_s8_s32(vdup_n_s32(input32[i]));
+      };
+
+      auto accumulate = [&](auto chunk, IndexType n) {
+        int32x4_t acc[NumRegs];
+        for (IndexType k = 0; k < NumRegs; ++k)
+            acc[k] = vdupq_n_s32(0);
+
+        IndexType j = 0;
+        for ( ; j + 1 < n; j += 2)
+        {
+            const int8x8_t in0 = duplicate(chunk(j)), in1 = duplicate(chunk(j + 1));
+            const int8x8_t* col0 = column(chunk(j));
+            const int8x8_t* col1 = column(chunk(j + 1));
+            for (IndexType k = 0; k < NumRegs; ++k)
+            {
+                int16x8_t product = vmull_s8(in0, col0[k]);
+                product = vmlal_s8(product, in1, col1[k]);
+                acc[k] = vpadalq_s16(acc[k], product);
+            }
+        }
+        if (j < n)
+        {
+            const int8x8_t in0 = duplicate(chunk(j));
+            const int8x8_t* col0 = column(chunk(j));
+            for (IndexType k = 0; k < NumRegs; ++k)
+                acc[k] = vpadalq_s16(acc[k], vmull_s8(in0, col0[k]));
+        }
+
+        for (IndexType k = 0; k < NumRegs; ++k)
+        {
+            output[2 * k]     = biases[2 * k]     + vgetq_lane_s32(acc[k], 0) + vgetq_lane_s32(acc[k], 1);
+            output[2 * k + 1] = biases[2 * k + 1] + vgetq_lane_s32(acc[k], 2) + vgetq_lane_s32(acc[k], 3);
+        }
+      };
+
+      if (count == NumChunks)
+          accumulate([](IndexType j) { return j; }, NumChunks);
+      else
+          accumulate([&](IndexType j) { return IndexType(nnz[j]); }, count);
+
+#endif
+    }
+
+    using BiasType = OutputType;
+    using WeightType = std::int8_t;
+
+    PreviousLayer previousLayer;
+
+    alignas(CacheLineSize) BiasType biases[OutputDimensions];
+    alignas(CacheLineSize) WeightType weights[OutputDimensions * PaddedInputDimensions];
+  };
+
+}  // namespace Stockfish::Eval::NNUE::Layers
+
+#endif // #ifndef NNUE_LAYERS_AFFINE_TRANSFORM_SPARSE_INPUT_H_INCLUDED
@@ -43,6 +43,9 @@ namespace Stockfish::Eval::NNUE::Layers {
     static constexpr std::size_t SelfBufferSize =
         ceil_to_multiple(OutputDimensions * sizeof(OutputType), CacheLineSize);
 
+    // Distance in bytes between the outputs of a batch
+    static constexpr std::size_t BatchStride = SelfBufferSize;
+
     // Size of the forward propagation buffer used from the input layer to this layer
     static constexpr std::size_t BufferSize =
         PreviousLayer::BufferSize + SelfBufferSize;
@@ -70,6 +73,44 @@ namespace Stockfish::Eval::NNUE::Layers {
       const auto input = previousLayer.propagate(
           transformedFeatures, buffer + SelfBufferSize);
       const auto output = reinterpret_cast<OutputType*>(buffer);
+      forward(input, output);
+      return output;
+    }
+
+    // Forward propagation from the accumulators, see AccumulatorInput
+    const OutputType* propagate(
+        const AccumulatorInput& accumulatorInput, char* buffer) const {
+      const auto input = previousLayer.propagate(
+          accumulatorInput, buffer + SelfBufferSize);
+      const auto output = reinterpret_cast<OutputType*>(buffer);
+      forward(input, output);
+      return output;
+    }
+
+    // Forward propagation of a batch of count inputs
+    const OutputType* propagate(
+        const TransformedFeatureType* transformedFeatures, char* buffer, IndexType count) const {
+      const auto input = reinterpret_cast<const char*>(previousLayer.propagate(
+          transformedFeatures, buffer + count * SelfBufferSize, count));
+      for (IndexType i = 0; i < count; ++i)
+        forward(reinterpret_cast<const InputType*>(input + i * PreviousLayer::BatchStride),
+                reinterpret_cast<OutputType*>(buffer + i * SelfBufferSize));
+      return reinterpret_cast<const OutputType*>(buffer);
+    }
+
+    // Forward propagation timing each layer on its own, see NNUE::benchmark()
+    template <typename Profiler>
+    const OutputType* profile(
+        const TransformedFeatureType* transformedFeatures, char* buffer, Profiler& profiler) const {
+      const auto input = previousLayer.profile(
+          transformedFeatures, buffer + SelfBufferSize, profiler);
+      const auto output = reinterpret_cast<OutputType*>(buffer);
+      profiler("ClippedReLU", OutputDimensions, InputDimensions, 0, [&]() { forward(input, output); });
+      return output;
+    }
+
+   private:
+    void forward(const InputType* input, OutputType* output) const {
 
   #if defined(USE_AVX2)
       if constexpr (InputDimensions % SimdWidth == 0) {
@@ -179,10 +220,8 @@ namespace Stockfish::Eval::NNUE::Layers {
         output[i] = static_cast<OutputType>(
             std::max(0, std::min(127, input[i] >> WeightScaleBits)));
       }
-      return output;
     }
 
-   private:
     PreviousLayer previousLayer;
   };
 
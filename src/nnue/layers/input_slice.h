@@ -41,6 +41,11 @@ class InputSlice {
   // Size of forward propagation buffer used from the input layer to this layer
   static constexpr std::size_t BufferSize = 0;
 
+  // Distance in bytes between the transformed features of the positions of a
+  // batch, which are stored one after the other
+  static constexpr std::size_t BatchStride =
+      ceil_to_multiple((Offset + OutputDimensions) * sizeof(OutputType), CacheLineSize);
+
   // Hash value embedded in the evaluation file
   static constexpr std::uint32_t get_hash_value() {
     std::uint32_t hashValue = 0xEC42E90Du;
@@ -65,6 +70,21 @@ class InputSlice {
     return transformedFeatures + Offset;
   }
 
+  // Forward propagation of a batch
+  const OutputType* propagate(
+      const TransformedFeatureType* transformedFeatures,
+      char* /*buffer*/, IndexType /*count*/) const {
+    return transformedFeatures + Offset;
+  }
+
+  // Forward propagation timing each layer on its own, see NNUE::benchmark()
+  template <typename Profiler>
+  const OutputType* profile(
+      const TransformedFeatureType* transformedFeatures,
+      char* /*buffer*/, Profiler& /*profiler*/) const {
+    return transformedFeatures + Offset;
+  }
+
  private:
 };
 
@@ -29,9 +29,52 @@ namespace Stockfish::Eval::NNUE {
   struct alignas(CacheLineSize) Accumulator {
     std::int16_t accumulation[2][TransformedFeatureDimensions];
     std::int32_t psqtAccumulation[2][PSQTBuckets];
+    std::uint64_t id; // The state the accumulator belongs to, see AccumulatorStack
     bool computed[2];
   };
 
+  // Per thread stack of accumulators, indexed by the ply from the position set
+  // up, modulo its size. A state takes the entry after the one of its parent
+  // with a new id, and the entry belongs to it as long as it carries this id:
+  // a later state at the same ply, e.g. a sibling, takes it over. A null move
+  // shares the entry of its parent, as the pieces did not change.
+  struct AccumulatorStack {
+
+    static constexpr int Size = MAX_PLY + 10;
+
+    // Takes the entry of a new state, the first one for a root state or one
+    // whose parent is not in this stack
+    Accumulator* push(const Accumulator* parent, std::uint64_t& id) {
+      Accumulator* a = contains(parent) ? entries + (parent - entries + 1) % Size : entries;
+      a->id = id = ++lastId;
+      a->computed[WHITE] = a->computed[BLACK] = false;
+      return a;
+    }
+
+    bool contains(const Accumulator* a) const {
+      return a >= entries && a < entries + Size;
+    }
+
+    Accumulator entries[Size];
+    std::uint64_t lastId = 0;
+  };
+
+  // Per thread cache of the accumulators last refreshed for each king square,
+  // with the pieces they were computed from, so that a refresh only has to
+  // apply the difference to the current pieces instead of adding all of them.
+  struct AccumulatorCache {
+
+    struct alignas(CacheLineSize) Entry {
+      std::int16_t accumulation[TransformedFeatureDimensions];
+      std::int32_t psqtAccumulation[PSQTBuckets];
+      Bitboard byColorBB[COLOR_NB];
+      Bitboard byTypeBB[PIECE_TYPE_NB];
+    };
+
+    Entry entries[SQUARE_NB][COLOR_NB];
+    std::uint32_t netId = 0; // The network the entries were computed with
+  };
+
 }  // namespace Stockfish::Eval::NNUE
 
 #endif // NNUE_ACCUMULATOR_H_INCLUDED
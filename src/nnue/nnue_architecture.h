@@ -27,6 +27,7 @@
 
 #include "layers/input_slice.h"
 #include "layers/affine_transform.h"
+#include "layers/affine_transform_sparse_input.h"
 #include "layers/clipped_relu.h"
 
 namespace Stockfish::Eval::NNUE {
@@ -43,7 +44,11 @@ namespace Stockfish::Eval::NNUE {
 
     // Define network structure
     using InputLayer = InputSlice<TransformedFeatureDimensions * 2>;
+#if defined (USE_AVX2) || defined (USE_NEON)
+    using HiddenLayer1 = ClippedReLU<AffineTransformSparseInput<InputLayer, 16>>;
+#else
     using HiddenLayer1 = ClippedReLU<AffineTransform<InputLayer, 16>>;
+#endif
     using HiddenLayer2 = ClippedReLU<AffineTransform<HiddenLayer1, 32>>;
     using OutputLayer = AffineTransform<HiddenLayer2, 1>;
 
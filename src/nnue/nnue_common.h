@@ -21,8 +21,11 @@
 #ifndef NNUE_COMMON_H_INCLUDED
 #define NNUE_COMMON_H_INCLUDED
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <type_traits>
+#include <vector>
 
 #include "../misc.h"  // for IsLittleEndian
 
@@ -77,6 +80,14 @@ namespace Stockfish::Eval::NNUE {
   using TransformedFeatureType = std::uint8_t;
   using IndexType = std::uint32_t;
 
+  // The accumulators of both perspectives of a position, the side to move
+  // first, as the input of the first hidden layer, which clips them into the
+  // transformed features itself, see AffineTransformSparseInput::forward()
+  struct AccumulatorInput {
+    const std::int16_t* accumulation[2];
+    TransformedFeatureType* transformedFeatures;
+  };
+
   // Round n up to be a multiple of base
   template <typename IntType>
   constexpr IntType ceil_to_multiple(IntType n, IntType base) {
@@ -159,6 +170,175 @@ namespace Stockfish::Eval::NNUE {
               write_little_endian<IntType>(stream, values[i]);
   }
 
+  // Marker of an array of integers compressed in signed LEB128, 7 bits per byte
+  // with the high bit set on all the bytes of an integer but the last. It is
+  // followed by the number of bytes of the compressed array.
+  constexpr char Leb128MagicString[] = "COMPRESSED_LEB128";
+  constexpr std::size_t Leb128MagicStringSize = sizeof(Leb128MagicString) - 1;
+
+  // Maximum number of bytes of an integer in signed LEB128
+  template <typename IntType>
+  constexpr std::size_t Leb128MaxLength = (sizeof(IntType) * 8 + 6) / 7;
+
+  // read_leb_128(s, out, N) : read N integers in bulk, compressed in signed LEB128
+  // or, without the marker, in little-endian as read_little_endian() does. The
+  // compressed bytes are read by blocks and decoded straight into array out.
+  template <typename IntType>
+  inline void read_leb_128(std::istream& stream, IntType* out, std::size_t count) {
+
+      static_assert(std::is_signed_v<IntType>, "Not implemented for unsigned types");
+
+      char magic[Leb128MagicStringSize];
+      stream.read(magic, Leb128MagicStringSize);
+
+      // Not compressed, the bytes read are the first ones of the array
+      if (std::memcmp(magic, Leb128MagicString, Leb128MagicStringSize))
+      {
+          if (count * sizeof(IntType) < Leb128MagicStringSize)
+          {
+              stream.setstate(std::ios::failbit);
+              return;
+          }
+
+          auto bytes = reinterpret_cast<char*>(out);
+          std::memcpy(bytes, magic, Leb128MagicStringSize);
+          stream.read(bytes + Leb128MagicStringSize, count * sizeof(IntType) - Leb128MagicStringSize);
+
+          if (!IsLittleEndian)
+              for (std::size_t i = 0; i < count; ++i)
+              {
+                  char u[sizeof(IntType)];
+                  std::memcpy(u, &out[i], sizeof(IntType));
+                  std::reverse(u, u + sizeof(IntType));
+                  std::memcpy(&out[i], u, sizeof(IntType));
+              }
+          return;
+      }
+
+      constexpr std::size_t BlockSize = 64 * 1024;
+      constexpr std::size_t MaxLength = Leb128MaxLength<IntType>;
+
+      // Bytes kept in the block before a refill, enough for an integer or for
+      // 8 integers of a single byte, decoded at once
+      constexpr std::size_t Lookahead = std::max<std::size_t>(MaxLength, 8);
+
+      std::uint32_t bytesLeft = read_little_endian<std::uint32_t>(stream);
+      std::vector<std::uint8_t> block(BlockSize + Lookahead);
+      std::size_t begin = 0, end = 0;
+
+      auto single_byte = [](std::uint8_t byte) { return IntType(std::int8_t(byte << 1) >> 1); };
+
+      for (std::size_t i = 0; i < count; )
+      {
+          if (end - begin < Lookahead && bytesLeft)
+          {
+              std::memmove(block.data(), block.data() + begin, end - begin);
+              end -= begin;
+              begin = 0;
+
+              const std::size_t n = std::min<std::size_t>(bytesLeft, BlockSize);
+              stream.read(reinterpret_cast<char*>(block.data() + end), n);
+              if (!stream)
+                  return;
+
+              end += n;
+              bytesLeft -= std::uint32_t(n);
+          }
+
+          // Most weights are small enough for a single byte
+          if (end - begin >= 8 && count - i >= 8)
+          {
+              std::uint64_t bytes;
+              std::memcpy(&bytes, &block[begin], 8);
+
+              if (!(bytes & 0x8080808080808080ULL))
+              {
+                  for (std::size_t k = 0; k < 8; ++k)
+                      out[i + k] = single_byte(block[begin + k]);
+
+                  begin += 8;
+                  i += 8;
+                  continue;
+              }
+          }
+
+          std::uint64_t value = 0;
+          std::size_t shift = 0;
+          std::uint8_t byte;
+
+          do {
+              if (begin == end || shift >= MaxLength * 7)
+              {
+                  stream.setstate(std::ios::failbit);
+                  return;
+              }
+
+              byte = block[begin++];
+              value |= std::uint64_t(byte & 0x7F) << shift;
+              shift += 7;
+          } while (byte & 0x80);
+
+          // Extend the sign bit of the last byte
+          if (byte & 0x40)
+              value |= ~std::uint64_t(0) << shift;
+
+          out[i++] = IntType(std::int64_t(value));
+      }
+
+      // The number of bytes must match the integers decoded
+      if (begin != end || bytesLeft)
+          stream.setstate(std::ios::failbit);
+  }
+
+  // write_leb_128(s, values, N) : write N integers in bulk, compressed in signed
+  // LEB128 after the marker and their number of bytes.
+  template <typename IntType>
+  inline void write_leb_128(std::ostream& stream, const IntType* values, std::size_t count) {
+
+      static_assert(std::is_signed_v<IntType>, "Not implemented for unsigned types");
+
+      constexpr std::size_t BlockSize = 64 * 1024;
+
+      // Calls f with each byte of the encoding of value
+      auto encode = [](IntType value, auto&& f) {
+          std::int64_t v = value;
+          while (true)
+          {
+              const std::uint8_t byte = v & 0x7F;
+              v >>= 7;
+              if ((v == 0 && !(byte & 0x40)) || (v == -1 && (byte & 0x40)))
+              {
+                  f(byte);
+                  return;
+              }
+              f(byte | 0x80);
+          }
+      };
+
+      std::uint32_t size = 0;
+      for (std::size_t i = 0; i < count; ++i)
+          encode(values[i], [&](std::uint8_t) { ++size; });
+
+      stream.write(Leb128MagicString, Leb128MagicStringSize);
+      write_little_endian<std::uint32_t>(stream, size);
+
+      std::vector<char> block;
+      block.reserve(BlockSize);
+
+      for (std::size_t i = 0; i < count; ++i)
+      {
+          encode(values[i], [&](std::uint8_t byte) { block.push_back(char(byte)); });
+
+          if (block.size() + Leb128MaxLength<IntType> > BlockSize)
+          {
+              stream.write(block.data(), block.size());
+              block.clear();
+          }
+      }
+
+      stream.write(block.data(), block.size());
+  }
+
 }  // namespace Stockfish::Eval::NNUE
 
 #endif // #ifndef NNUE_COMMON_H_INCLUDED
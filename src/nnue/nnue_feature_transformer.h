@@ -23,6 +23,7 @@
 
 #include "nnue_common.h"
 #include "nnue_architecture.h"
+#include "nnue_accumulator.h"
 
 #include <cstring> // std::memset()
 
@@ -170,6 +171,9 @@ namespace Stockfish::Eval::NNUE {
     // Number of output dimensions for one side
     static constexpr IndexType HalfDimensions = TransformedFeatureDimensions;
 
+    // Pieces above which a refresh goes through the accumulator cache
+    static constexpr int CacheMinRefreshCost = 8;
+
     #ifdef VECTOR
     static constexpr IndexType TileHeight = NumRegs * sizeof(vec_t) / 2;
     static constexpr IndexType PsqtTileHeight = NumPsqtRegs * sizeof(psqt_vec_t) / 4;
@@ -194,34 +198,52 @@ namespace Stockfish::Eval::NNUE {
       return FeatureSet::HashValue ^ OutputDimensions;
     }
 
-    // Read network parameters
+    // Read network parameters, compressed in LEB128 or not
     bool read_parameters(std::istream& stream) {
 
-      read_little_endian<BiasType      >(stream, biases     , HalfDimensions                  );
-      read_little_endian<WeightType    >(stream, weights    , HalfDimensions * InputDimensions);
-      read_little_endian<PSQTWeightType>(stream, psqtWeights, PSQTBuckets    * InputDimensions);
+      read_leb_128<BiasType      >(stream, biases     , HalfDimensions                  );
+      read_leb_128<WeightType    >(stream, weights    , HalfDimensions * InputDimensions);
+      read_leb_128<PSQTWeightType>(stream, psqtWeights, PSQTBuckets    * InputDimensions);
+
+      // Tell the accumulator caches computed with another network apart
+      static std::uint32_t loads = 0;
+      netId = ++loads;
 
       return !stream.fail();
     }
 
-    // Write network parameters
-    bool write_parameters(std::ostream& stream) const {
+    // Write network parameters, compressed in LEB128 or not
+    bool write_parameters(std::ostream& stream, bool compressed) const {
 
-      write_little_endian<BiasType      >(stream, biases     , HalfDimensions                  );
-      write_little_endian<WeightType    >(stream, weights    , HalfDimensions * InputDimensions);
-      write_little_endian<PSQTWeightType>(stream, psqtWeights, PSQTBuckets    * InputDimensions);
+      if (compressed)
+      {
+          write_leb_128<BiasType      >(stream, biases     , HalfDimensions                  );
+          write_leb_128<WeightType    >(stream, weights    , HalfDimensions * InputDimensions);
+          write_leb_128<PSQTWeightType>(stream, psqtWeights, PSQTBuckets    * InputDimensions);
+      }
+      else
+      {
+          write_little_endian<BiasType      >(stream, biases     , HalfDimensions                  );
+          write_little_endian<WeightType    >(stream, weights    , HalfDimensions * InputDimensions);
+          write_little_endian<PSQTWeightType>(stream, psqtWeights, PSQTBuckets    * InputDimensions);
+      }
 
       return !stream.fail();
     }
 
+    // Bring the accumulators of both perspectives up to date
+    void update_accumulators(const Position& pos, AccumulatorCache& cache) const {
+      update_accumulator(pos, WHITE, cache);
+      update_accumulator(pos, BLACK, cache);
+    }
+
     // Convert input features
-    std::int32_t transform(const Position& pos, OutputType* output, int bucket) const {
-      update_accumulator(pos, WHITE);
-      update_accumulator(pos, BLACK);
+    std::int32_t transform(const Position& pos, AccumulatorCache& cache, OutputType* output, int bucket) const {
+      update_accumulators(pos, cache);
 
       const Color perspectives[2] = {pos.side_to_move(), ~pos.side_to_move()};
-      const auto& accumulation = pos.state()->accumulator.accumulation;
-      const auto& psqtAccumulation = pos.state()->accumulator.psqtAccumulation;
+      const auto& accumulation = pos.state()->accumulator->accumulation;
+      const auto& psqtAccumulation = pos.state()->accumulator->psqtAccumulation;
 
       const auto psqt = (
             psqtAccumulation[perspectives[0]][bucket]
@@ -361,10 +383,219 @@ namespace Stockfish::Eval::NNUE {
 
    } // end of function transform()
 
+    // Bring the accumulators up to date for the first hidden layer, which
+    // clips them itself, see AccumulatorInput
+    std::int32_t transform(const Position& pos, AccumulatorCache& cache, AccumulatorInput& input, int bucket) const {
+      update_accumulators(pos, cache);
+
+      const Color perspectives[2] = {pos.side_to_move(), ~pos.side_to_move()};
+      const auto& accumulator = *pos.state()->accumulator;
+
+      input.accumulation[0] = accumulator.accumulation[perspectives[0]];
+      input.accumulation[1] = accumulator.accumulation[perspectives[1]];
+
+      return (  accumulator.psqtAccumulation[perspectives[0]][bucket]
+              - accumulator.psqtAccumulation[perspectives[1]][bucket]) / 2;
+    }
+
 
 
    private:
-    void update_accumulator(const Position& pos, const Color perspective) const {
+    // Whether the accumulator of a state is computed for a perspective. It is
+    // not once a later state took over its entry of the accumulator stack.
+    static bool computed(const StateInfo* st, Color perspective) {
+      return st->accumulator->id == st->accumulatorId && st->accumulator->computed[perspective];
+    }
+
+    // Take back the entry of the accumulator stack of a state before writing it
+    static Accumulator& claim(const StateInfo* st) {
+
+      Accumulator& accumulator = *st->accumulator;
+      if (accumulator.id != st->accumulatorId)
+      {
+          accumulator.id = st->accumulatorId;
+          accumulator.computed[WHITE] = accumulator.computed[BLACK] = false;
+      }
+      return accumulator;
+    }
+
+    // Reset the entries of a cache to the accumulator of an empty board
+    void reset_cache(AccumulatorCache& cache) const {
+
+      for (auto& entries : cache.entries)
+          for (auto& entry : entries)
+          {
+              std::memcpy(entry.accumulation, biases, HalfDimensions * sizeof(BiasType));
+              std::memset(entry.psqtAccumulation, 0, sizeof(entry.psqtAccumulation));
+              std::memset(entry.byColorBB, 0, sizeof(entry.byColorBB));
+              std::memset(entry.byTypeBB, 0, sizeof(entry.byTypeBB));
+          }
+
+      cache.netId = netId;
+    }
+
+    // Refresh the accumulator from the one cached for the same king square,
+    // by applying the difference between the cached pieces and ours, or from
+    // scratch if there are fewer pieces than differences. Either way the result
+    // is cached for the next refresh. With few pieces left a refresh from
+    // scratch is cheaper than loading and storing the cached accumulator.
+    void refresh_accumulator(const Position& pos, const Color perspective, AccumulatorCache& cache) const {
+
+      using IndexList = ValueList<IndexType, FeatureSet::MaxActiveDimensions>;
+
+  #ifdef VECTOR
+      vec_t acc[NumRegs];
+      psqt_vec_t psqt[NumPsqtRegs];
+  #endif
+
+      if (cache.netId != netId)
+        reset_cache(cache);
+
+      auto& accumulator = claim(pos.state());
+      auto& entry = cache.entries[pos.square<KING>(perspective)][perspective];
+      const bool cached = FeatureSet::refresh_cost(pos) > CacheMinRefreshCost;
+      accumulator.computed[perspective] = true;
+      IndexList removed, added;
+
+      if (cached)
+        FeatureSet::append_changed_indices(
+          pos, perspective, entry.byColorBB, entry.byTypeBB, removed, added);
+
+      const bool fromScratch = !cached || int(removed.size() + added.size()) > FeatureSet::refresh_cost(pos);
+      if (fromScratch)
+      {
+        removed.resize(0);
+        added.resize(0);
+        FeatureSet::append_active_indices(pos, perspective, added);
+      }
+
+  #ifdef VECTOR
+      for (IndexType j = 0; j < HalfDimensions / TileHeight; ++j)
+      {
+        auto entryTile = reinterpret_cast<vec_t*>(
+            &entry.accumulation[j * TileHeight]);
+        auto sourceTile = fromScratch ? reinterpret_cast<const vec_t*>(&biases[j * TileHeight]) : entryTile;
+        for (IndexType k = 0; k < NumRegs; ++k)
+          acc[k] = vec_load(&sourceTile[k]);
+
+        for (const auto index : removed)
+        {
+          const IndexType offset = HalfDimensions * index + j * TileHeight;
+          auto column = reinterpret_cast<const vec_t*>(&weights[offset]);
+
+          for (unsigned k = 0; k < NumRegs; ++k)
+            acc[k] = vec_sub_16(acc[k], column[k]);
+        }
+
+        for (const auto index : added)
+        {
+          const IndexType offset = HalfDimensions * index + j * TileHeight;
+          auto column = reinterpret_cast<const vec_t*>(&weights[offset]);
+
+          for (unsigned k = 0; k < NumRegs; ++k)
+            acc[k] = vec_add_16(acc[k], column[k]);
+        }
+
+        auto accTile = reinterpret_cast<vec_t*>(
+            &accumulator.accumulation[perspective][j * TileHeight]);
+        for (unsigned k = 0; k < NumRegs; k++)
+          vec_store(&accTile[k], acc[k]);
+
+        if (cached)
+          for (unsigned k = 0; k < NumRegs; k++)
+            vec_store(&entryTile[k], acc[k]);
+      }
+
+      for (IndexType j = 0; j < PSQTBuckets / PsqtTileHeight; ++j)
+      {
+        auto entryTilePsqt = reinterpret_cast<psqt_vec_t*>(
+            &entry.psqtAccumulation[j * PsqtTileHeight]);
+        for (std::size_t k = 0; k < NumPsqtRegs; ++k)
+          psqt[k] = fromScratch ? vec_zero_psqt() : vec_load_psqt(&entryTilePsqt[k]);
+
+        for (const auto index : removed)
+        {
+          const IndexType offset = PSQTBuckets * index + j * PsqtTileHeight;
+          auto columnPsqt = reinterpret_cast<const psqt_vec_t*>(&psqtWeights[offset]);
+
+          for (std::size_t k = 0; k < NumPsqtRegs; ++k)
+            psqt[k] = vec_sub_psqt_32(psqt[k], columnPsqt[k]);
+        }
+
+        for (const auto index : added)
+        {
+          const IndexType offset = PSQTBuckets * index + j * PsqtTileHeight;
+          auto columnPsqt = reinterpret_cast<const psqt_vec_t*>(&psqtWeights[offset]);
+
+          for (std::size_t k = 0; k < NumPsqtRegs; ++k)
+            psqt[k] = vec_add_psqt_32(psqt[k], columnPsqt[k]);
+        }
+
+        auto accTilePsqt = reinterpret_cast<psqt_vec_t*>(
+          &accumulator.psqtAccumulation[perspective][j * PsqtTileHeight]);
+        for (std::size_t k = 0; k < NumPsqtRegs; ++k)
+          vec_store_psqt(&accTilePsqt[k], psqt[k]);
+
+        if (cached)
+          for (std::size_t k = 0; k < NumPsqtRegs; ++k)
+            vec_store_psqt(&entryTilePsqt[k], psqt[k]);
+      }
+
+  #else
+      auto& accumulation = accumulator.accumulation[perspective];
+      auto& psqtAccumulation = accumulator.psqtAccumulation[perspective];
+
+      if (fromScratch)
+      {
+        std::memcpy(accumulation, biases, HalfDimensions * sizeof(BiasType));
+        std::memset(psqtAccumulation, 0, PSQTBuckets * sizeof(PSQTWeightType));
+      }
+      else
+      {
+        std::memcpy(accumulation, entry.accumulation, HalfDimensions * sizeof(BiasType));
+        std::memcpy(psqtAccumulation, entry.psqtAccumulation, PSQTBuckets * sizeof(PSQTWeightType));
+      }
+
+      for (const auto index : removed)
+      {
+        const IndexType offset = HalfDimensions * index;
+
+        for (IndexType j = 0; j < HalfDimensions; ++j)
+          accumulation[j] -= weights[offset + j];
+
+        for (std::size_t k = 0; k < PSQTBuckets; ++k)
+          psqtAccumulation[k] -= psqtWeights[index * PSQTBuckets + k];
+      }
+
+      for (const auto index : added)
+      {
+        const IndexType offset = HalfDimensions * index;
+
+        for (IndexType j = 0; j < HalfDimensions; ++j)
+          accumulation[j] += weights[offset + j];
+
+        for (std::size_t k = 0; k < PSQTBuckets; ++k)
+          psqtAccumulation[k] += psqtWeights[index * PSQTBuckets + k];
+      }
+
+      if (cached)
+      {
+        std::memcpy(entry.accumulation, accumulation, HalfDimensions * sizeof(BiasType));
+        std::memcpy(entry.psqtAccumulation, psqtAccumulation, PSQTBuckets * sizeof(PSQTWeightType));
+      }
+  #endif
+
+      if (!cached)
+        return;
+
+      for (Color c : { WHITE, BLACK })
+        entry.byColorBB[c] = pos.pieces(c);
+
+      for (PieceType pt = PAWN; pt <= KING; ++pt)
+        entry.byTypeBB[pt] = pos.pieces(pt);
+    }
+
+    void update_accumulator(const Position& pos, const Color perspective, AccumulatorCache& cache) const {
 
       // The size must be enough to contain the largest possible update.
       // That might depend on the feature set and generally relies on the
@@ -383,7 +614,9 @@ namespace Stockfish::Eval::NNUE {
       // of the estimated gain in terms of features to be added/subtracted.
       StateInfo *st = pos.state(), *next = nullptr;
       int gain = FeatureSet::refresh_cost(pos);
-      while (st->previous && !st->accumulator.computed[perspective])
+      while (   st->previous
+             && pos.accumulator_stack()->contains(st->previous->accumulator)
+             && !computed(st, perspective))
       {
         // This governs when a full feature refresh is needed and how many
         // updates are better than just one full refresh.
@@ -394,7 +627,7 @@ namespace Stockfish::Eval::NNUE {
         st = st->previous;
       }
 
-      if (st->accumulator.computed[perspective])
+      if (computed(st, perspective))
       {
         if (next == nullptr)
           return;
@@ -412,8 +645,8 @@ namespace Stockfish::Eval::NNUE {
             ksq, st2, perspective, removed[1], added[1]);
 
         // Mark the accumulators as computed.
-        next->accumulator.computed[perspective] = true;
-        pos.state()->accumulator.computed[perspective] = true;
+        claim(next).computed[perspective] = true;
+        claim(pos.state()).computed[perspective] = true;
 
         // Now update the accumulators listed in states_to_update[], where the last element is a sentinel.
         StateInfo *states_to_update[3] =
@@ -423,7 +656,7 @@ namespace Stockfish::Eval::NNUE {
         {
           // Load accumulator
           auto accTile = reinterpret_cast<vec_t*>(
-            &st->accumulator.accumulation[perspective][j * TileHeight]);
+            &st->accumulator->accumulation[perspective][j * TileHeight]);
           for (IndexType k = 0; k < NumRegs; ++k)
             acc[k] = vec_load(&accTile[k]);
 
@@ -449,7 +682,7 @@ namespace Stockfish::Eval::NNUE {
 
             // Store accumulator
             accTile = reinterpret_cast<vec_t*>(
-              &states_to_update[i]->accumulator.accumulation[perspective][j * TileHeight]);
+              &states_to_update[i]->accumulator->accumulation[perspective][j * TileHeight]);
             for (IndexType k = 0; k < NumRegs; ++k)
               vec_store(&accTile[k], acc[k]);
           }
@@ -459,7 +692,7 @@ namespace Stockfish::Eval::NNUE {
         {
           // Load accumulator
           auto accTilePsqt = reinterpret_cast<psqt_vec_t*>(
-            &st->accumulator.psqtAccumulation[perspective][j * PsqtTileHeight]);
+            &st->accumulator->psqtAccumulation[perspective][j * PsqtTileHeight]);
           for (std::size_t k = 0; k < NumPsqtRegs; ++k)
             psqt[k] = vec_load_psqt(&accTilePsqt[k]);
 
@@ -485,7 +718,7 @@ namespace Stockfish::Eval::NNUE {
 
             // Store accumulator
             accTilePsqt = reinterpret_cast<psqt_vec_t*>(
-              &states_to_update[i]->accumulator.psqtAccumulation[perspective][j * PsqtTileHeight]);
+              &states_to_update[i]->accumulator->psqtAccumulation[perspective][j * PsqtTileHeight]);
             for (std::size_t k = 0; k < NumPsqtRegs; ++k)
               vec_store_psqt(&accTilePsqt[k], psqt[k]);
           }
@@ -494,12 +727,12 @@ namespace Stockfish::Eval::NNUE {
   #else
         for (IndexType i = 0; states_to_update[i]; ++i)
         {
-          std::memcpy(states_to_update[i]->accumulator.accumulation[perspective],
-              st->accumulator.accumulation[perspective],
+          std::memcpy(states_to_update[i]->accumulator->accumulation[perspective],
+              st->accumulator->accumulation[perspective],
               HalfDimensions * sizeof(BiasType));
 
           for (std::size_t k = 0; k < PSQTBuckets; ++k)
-            states_to_update[i]->accumulator.psqtAccumulation[perspective][k] = st->accumulator.psqtAccumulation[perspective][k];
+            states_to_update[i]->accumulator->psqtAccumulation[perspective][k] = st->accumulator->psqtAccumulation[perspective][k];
 
           st = states_to_update[i];
 
@@ -509,10 +742,10 @@ namespace Stockfish::Eval::NNUE {
             const IndexType offset = HalfDimensions * index;
 
             for (IndexType j = 0; j < HalfDimensions; ++j)
-              st->accumulator.accumulation[perspective][j] -= weights[offset + j];
+              st->accumulator->accumulation[perspective][j] -= weights[offset + j];
 
             for (std::size_t k = 0; k < PSQTBuckets; ++k)
-              st->accumulator.psqtAccumulation[perspective][k] -= psqtWeights[index * PSQTBuckets + k];
+              st->accumulator->psqtAccumulation[perspective][k] -= psqtWeights[index * PSQTBuckets + k];
           }
 
           // Difference calculation for the activated features
@@ -521,84 +754,16 @@ namespace Stockfish::Eval::NNUE {
             const IndexType offset = HalfDimensions * index;
 
             for (IndexType j = 0; j < HalfDimensions; ++j)
-              st->accumulator.accumulation[perspective][j] += weights[offset + j];
+              st->accumulator->accumulation[perspective][j] += weights[offset + j];
 
             for (std::size_t k = 0; k < PSQTBuckets; ++k)
-              st->accumulator.psqtAccumulation[perspective][k] += psqtWeights[index * PSQTBuckets + k];
+              st->accumulator->psqtAccumulation[perspective][k] += psqtWeights[index * PSQTBuckets + k];
           }
         }
   #endif
       }
       else
-      {
-        // Refresh the accumulator
-        auto& accumulator = pos.state()->accumulator;
-        accumulator.computed[perspective] = true;
-        IndexList active;
-        FeatureSet::append_active_indices(pos, perspective, active);
-
-  #ifdef VECTOR
-        for (IndexType j = 0; j < HalfDimensions / TileHeight; ++j)
-        {
-          auto biasesTile = reinterpret_cast<const vec_t*>(
-              &biases[j * TileHeight]);
-          for (IndexType k = 0; k < NumRegs; ++k)
-            acc[k] = biasesTile[k];
-
-          for (const auto index : active)
-          {
-            const IndexType offset = HalfDimensions * index + j * TileHeight;
-            auto column = reinterpret_cast<const vec_t*>(&weights[offset]);
-
-            for (unsigned k = 0; k < NumRegs; ++k)
-              acc[k] = vec_add_16(acc[k], column[k]);
-          }
-
-          auto accTile = reinterpret_cast<vec_t*>(
-              &accumulator.accumulation[perspective][j * TileHeight]);
-          for (unsigned k = 0; k < NumRegs; k++)
-            vec_store(&accTile[k], acc[k]);
-        }
-
-        for (IndexType j = 0; j < PSQTBuckets / PsqtTileHeight; ++j)
-        {
-          for (std::size_t k = 0; k < NumPsqtRegs; ++k)
-            psqt[k] = vec_zero_psqt();
-
-          for (const auto index : active)
-          {
-            const IndexType offset = PSQTBuckets * index + j * PsqtTileHeight;
-            auto columnPsqt = reinterpret_cast<const psqt_vec_t*>(&psqtWeights[offset]);
-
-            for (std::size_t k = 0; k < NumPsqtRegs; ++k)
-              psqt[k] = vec_add_psqt_32(psqt[k], columnPsqt[k]);
-          }
-
-          auto accTilePsqt = reinterpret_cast<psqt_vec_t*>(
-            &accumulator.psqtAccumulation[perspective][j * PsqtTileHeight]);
-          for (std::size_t k = 0; k < NumPsqtRegs; ++k)
-            vec_store_psqt(&accTilePsqt[k], psqt[k]);
-        }
-
-  #else
-        std::memcpy(accumulator.accumulation[perspective], biases,
-            HalfDimensions * sizeof(BiasType));
-
-        for (std::size_t k = 0; k < PSQTBuckets; ++k)
-          accumulator.psqtAccumulation[perspective][k] = 0;
-
-        for (const auto index : active)
-        {
-          const IndexType offset = HalfDimensions * index;
-
-          for (IndexType j = 0; j < HalfDimensions; ++j)
-            accumulator.accumulation[perspective][j] += weights[offset + j];
-
-          for (std::size_t k = 0; k < PSQTBuckets; ++k)
-            accumulator.psqtAccumulation[perspective][k] += psqtWeights[index * PSQTBuckets + k];
-        }
-  #endif
-      }
+        refresh_accumulator(pos, perspective, cache);
 
   #if defined(USE_MMX)
       _mm_empty();
@@ -608,6 +773,7 @@ namespace Stockfish::Eval::NNUE {
     alignas(CacheLineSize) BiasType biases[HalfDimensions];
     alignas(CacheLineSize) WeightType weights[HalfDimensions * InputDimensions];
     alignas(CacheLineSize) PSQTWeightType psqtWeights[InputDimensions * PSQTBuckets];
+    std::uint32_t netId;
   };
 
 }  // namespace Stockfish::Eval::NNUE
@@ -79,7 +79,6 @@ std::ostream& operator<<(std::ostream& os, const Position& pos) {
       && !pos.can_castle(ANY_CASTLING))
   {
       StateInfo st;
-      ASSERT_ALIGNED(&st, Eval::NNUE::CacheLineSize);
 
       Position p;
       p.set(pos.fen(), pos.is_chess960(), &st, pos.this_thread());
@@ -1061,6 +1060,9 @@ Position& Position::set(const string& fenStr, bool isChess960, StateInfo* si, Th
 
   chess960 = isChess960;
   thisThread = th;
+  accumulatorStack = th ? &th->accumulatorStack : nullptr;
+  st->accumulator = th ? accumulatorStack->push(nullptr, st->accumulatorId) : nullptr;
+  ASSERT_ALIGNED(st->accumulator, Eval::NNUE::CacheLineSize);
   set_state(st);
 
   assert(pos_is_ok());
@@ -1464,6 +1466,7 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
 
   assert(is_ok(m));
   assert(&newSt != st);
+  assert(accumulatorStack);
 
   thisThread->nodes.fetch_add(1, std::memory_order_relaxed);
   Key k = st->key ^ Zobrist::side;
@@ -1482,8 +1485,8 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
   ++st->pliesFromNull;
 
   // Used by NNUE
-  st->accumulator.computed[WHITE] = false;
-  st->accumulator.computed[BLACK] = false;
+  st->accumulator = accumulatorStack->push(st->previous->accumulator, st->accumulatorId);
+  ASSERT_ALIGNED(st->accumulator, Eval::NNUE::CacheLineSize);
   auto& dp = st->dirtyPiece;
   dp.dirty_num = 1;
 
@@ -1775,16 +1778,16 @@ void Position::do_null_move(StateInfo& newSt) {
 
   assert(!checkers());
   assert(&newSt != st);
+  assert(accumulatorStack);
 
-  std::memcpy(&newSt, st, offsetof(StateInfo, accumulator));
+  // The accumulator of the parent is shared, see AccumulatorStack
+  std::memcpy(&newSt, st, offsetof(StateInfo, dirtyPiece));
 
   newSt.previous = st;
   st = &newSt;
 
   st->dirtyPiece.dirty_num = 0;
   st->dirtyPiece.piece[0] = NO_PIECE; // Avoid checks in UpdateAccumulator()
-  st->accumulator.computed[WHITE] = false;
-  st->accumulator.computed[BLACK] = false;
 
   if (st->epSquare != SQ_NONE)
   {
@@ -1838,6 +1841,28 @@ Key Position::key_after(Move m) const {
 }
 
 
+/// Position::pawn_key_after() computes the new pawn hash key after the given
+/// move, with the same limitations as key_after(). Needed for speculative
+/// prefetch of the pawn hash entry.
+
+Key Position::pawn_key_after(Move m) const {
+
+  Square from = from_sq(m);
+  Square to = to_sq(m);
+  Piece pc = piece_on(from);
+  Piece captured = piece_on(to);
+  Key k = st->pawnKey;
+
+  if (type_of(captured) == PAWN)
+      k ^= Zobrist::psq[captured][to];
+
+  if (type_of(pc) == PAWN)
+      k ^= Zobrist::psq[pc][to] ^ Zobrist::psq[pc][from];
+
+  return k;
+}
+
+
 /// Position::see_ge (Static Exchange Evaluation Greater or Equal) tests if the
 /// SEE value of move is greater or equal to the given threshold. We'll use an
 /// algorithm similar to alpha-beta pruning with a null window.
@@ -2099,7 +2124,6 @@ bool Position::pos_is_ok() const {
               assert(0 && "pos_is_ok: Bitboards");
 
   StateInfo si = *st;
-  ASSERT_ALIGNED(&si, Eval::NNUE::CacheLineSize);
 
   set_state(&si);
   if (std::memcmp(&si, st, sizeof(StateInfo)))
@@ -59,7 +59,8 @@ struct StateInfo {
   int        repetition;
 
   // Used by NNUE
-  Eval::NNUE::Accumulator accumulator;
+  Eval::NNUE::Accumulator* accumulator; // Entry of the accumulator stack of the thread
+  uint64_t accumulatorId;               // Id of the entry while it belongs to this state
   DirtyPiece dirtyPiece;
 };
 
@@ -148,6 +149,7 @@ public:
   // Accessing hash keys
   Key key() const;
   Key key_after(Move m) const;
+  Key pawn_key_after(Move m) const;
   Key material_key() const;
   Key pawn_key() const;
 
@@ -156,6 +158,7 @@ public:
   int game_ply() const;
   bool is_chess960() const;
   Thread* this_thread() const;
+  const Eval::NNUE::AccumulatorStack* accumulator_stack() const;
   bool is_draw(int ply) const;
   bool has_game_cycle(int ply) const;
   bool has_repeated() const;
@@ -194,6 +197,7 @@ private:
   Square castlingRookSquare[CASTLING_RIGHT_NB];
   Bitboard castlingPath[CASTLING_RIGHT_NB];
   Thread* thisThread;
+  Eval::NNUE::AccumulatorStack* accumulatorStack;
   StateInfo* st;
   int gamePly;
   Color sideToMove;
@@ -371,6 +375,10 @@ inline Thread* Position::this_thread() const {
   return thisThread;
 }
 
+inline const Eval::NNUE::AccumulatorStack* Position::accumulator_stack() const {
+  return accumulatorStack;
+}
+
 inline void Position::put_piece(Piece pc, Square s) {
 
   board[s] = pc;
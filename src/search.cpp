@@ -24,6 +24,8 @@
 #include <sstream>
 
 #include "polybook.h"
+#include "analysis.h"
+#include "cluster.h"
 #include "evaluate.h"
 #include "misc.h"
 #include "movegen.h"
@@ -118,32 +120,213 @@ namespace {
   void update_all_stats(const Position& pos, Stack* ss, Move bestMove, Value bestValue, Value beta, Square prevSq,
                         Move* quietsSearched, int quietCount, Move* capturesSearched, int captureCount, Depth depth);
 
+  // PerftTable caches the leaf counts of perft() subtrees, indexed by the full
+  // position key and the remaining depth. It is shared by all the threads and
+  // lockless: the key is stored xored with the data, so that an entry torn by
+  // concurrent writes is never mistaken for a valid one.
+  class PerftTable {
+
+    struct Entry {
+      uint64_t keyXorData;
+      uint64_t data; // Leaf count << 8 | depth
+    };
+
+  public:
+   ~PerftTable() { aligned_large_pages_free(table); }
+
+    void resize(size_t mbSize) {
+
+      if (mbSize != sizeMB)
+      {
+          aligned_large_pages_free(table);
+          count = mbSize * 1024 * 1024 / sizeof(Entry);
+          table = count ? static_cast<Entry*>(aligned_large_pages_alloc(count * sizeof(Entry))) : nullptr;
+          count = table ? count : 0;
+          sizeMB = mbSize;
+      }
+      if (table)
+          std::memset(table, 0, count * sizeof(Entry));
+    }
+
+    bool probe(Key key, Depth depth, uint64_t& cnt) const {
+
+      if (!count)
+          return false;
+
+      const Entry& e = table[mul_hi64(key ^ (uint64_t(depth) * 0x9E3779B97F4A7C15ULL), count)];
+      const uint64_t data = e.data;
+
+      if ((e.keyXorData ^ data) != key || (data & 0xFF) != uint64_t(depth))
+          return false;
+
+      cnt = data >> 8;
+      return true;
+    }
+
+    void store(Key key, Depth depth, uint64_t cnt) {
+
+      if (!count)
+          return;
+
+      Entry& e = table[mul_hi64(key ^ (uint64_t(depth) * 0x9E3779B97F4A7C15ULL), count)];
+      e.data = cnt << 8 | uint64_t(depth);
+      e.keyXorData = key ^ e.data;
+    }
+
+  private:
+    Entry* table = nullptr;
+    size_t count = 0, sizeMB = 0;
+  };
+
+  PerftTable PerftTT;
+
+  // SearchingTable is used by the ABDADA work sharing mode: it holds the keys
+  // of the (position, move) pairs being searched by some thread, so that the
+  // other threads search these moves last and explore another part of the tree.
+  // Deferring is only a heuristic, so lost or stale entries do no harm.
+  class SearchingTable {
+
+    static constexpr int Size = 1 << 15;
+    static constexpr int Ways = 4;
+
+    std::atomic<Key> table[Size][Ways];
+
+  public:
+    static constexpr Depth MinDepth = 3; // Shallower nodes are not shared
+
+    static Key move_key(const Position& pos, Move m) {
+      return pos.key() ^ (uint64_t(m) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    bool busy(Key k) const {
+      for (const auto& e : table[k & (Size - 1)])
+          if (e.load(std::memory_order_relaxed) == k)
+              return true;
+      return false;
+    }
+
+    void start(Key k) {
+      auto& bucket = table[k & (Size - 1)];
+      for (auto& e : bucket)
+      {
+          Key old = e.load(std::memory_order_relaxed);
+          if (old == k)
+              return;
+          if (!old)
+              return e.store(k, std::memory_order_relaxed);
+      }
+      bucket[0].store(k, std::memory_order_relaxed);
+    }
+
+    void finish(Key k) {
+      for (auto& e : table[k & (Size - 1)])
+          if (e.load(std::memory_order_relaxed) == k)
+              e.store(0, std::memory_order_relaxed);
+    }
+  };
+
+  SearchingTable Searching;
+  bool UseABDADA; // Set at the start of every search from "SMP Mode"
+
+  // With "MultiPV Split" the PV lines are shared out among the threads instead
+  // of being all searched by every thread. Threads publish the lines they have
+  // searched in SharedLines, and adopt the lines of the others before each of
+  // their iterations, so that each line excludes the right moves.
+  struct SharedLines {
+    std::mutex mutex;
+    RootMoves lines; // Last result of each PV line, MOVE_NONE if none
+  } PVLines;
+
+  bool SplitMultiPV; // Set at the start of every search
+
+  // Thread idx searches line k, either alone or with other threads if there
+  // are more threads than lines.
+  bool owns_line(size_t idx, size_t k, size_t multiPV) {
+    size_t n = Threads.size();
+    return n >= multiPV ? k == idx % multiPV : k % n == idx;
+  }
+
+  void publish_line(size_t k, const RootMove& rm, Depth depth) {
+
+    std::scoped_lock<std::mutex> lk(PVLines.mutex);
+
+    // A move is the result of one line only, the other one is now outdated
+    for (RootMove& line : PVLines.lines)
+        if (line.pv[0] == rm.pv[0])
+            line = RootMove(MOVE_NONE);
+
+    PVLines.lines[k] = rm;
+    PVLines.lines[k].lineDepth = depth;
+  }
+
+  // Brings the moves of the published lines to the front, in line order
+  void adopt_lines(RootMoves& rootMoves) {
+
+    std::scoped_lock<std::mutex> lk(PVLines.mutex);
+
+    auto first = rootMoves.begin();
+    for (const RootMove& line : PVLines.lines)
+    {
+        auto it = std::find(first, rootMoves.end(), line.pv[0]);
+        if (line.pv[0] == MOVE_NONE || it == rootMoves.end())
+            continue;
+
+        *it = line;
+        std::rotate(first, it, it + 1);
+        ++first;
+    }
+  }
+
+  // Root moves of the running perft with their leaf counts. Threads pick the
+  // next move to count from perftNext, so that the work is shared dynamically.
+  std::vector<std::pair<Move, uint64_t>> perftMoves;
+  std::atomic<size_t> perftNext;
+
   // perft() is our utility to verify move generation. All the leaf nodes up
   // to the given depth are generated and counted, and the sum is returned.
-  template<bool Root>
+  // The last ply is bulk counted, and subtree counts are cached in PerftTT.
   uint64_t perft(Position& pos, Depth depth) {
 
-    StateInfo st;
-    ASSERT_ALIGNED(&st, Eval::NNUE::CacheLineSize);
+    if (depth == 1)
+        return MoveList<LEGAL>(pos).size();
 
-    uint64_t cnt, nodes = 0;
-    const bool leaf = (depth == 2);
+    uint64_t nodes = 0;
+    if (PerftTT.probe(pos.key(), depth, nodes))
+        return nodes;
+
+    StateInfo st;
 
     for (const auto& m : MoveList<LEGAL>(pos))
     {
-        if (Root && depth <= 1)
-            cnt = 1, nodes++;
-        else
+        pos.do_move(m, st);
+        nodes += perft(pos, depth - 1);
+        pos.undo_move(m);
+    }
+
+    PerftTT.store(pos.key(), depth, nodes);
+    return nodes;
+  }
+
+  // perft_split() is run by every thread of the pool: it counts the subtrees
+  // of the root moves not yet taken by another thread.
+  void perft_split(Thread* th, Depth depth) {
+
+    StateInfo st;
+
+    for (size_t i = perftNext++; i < perftMoves.size(); i = perftNext++)
+    {
+        Move m = perftMoves[i].first;
+        uint64_t cnt = 1;
+
+        if (depth > 1)
         {
-            pos.do_move(m, st);
-            cnt = leaf ? MoveList<LEGAL>(pos).size() : perft<false>(pos, depth - 1);
-            nodes += cnt;
-            pos.undo_move(m);
+            th->rootPos.do_move(m, st);
+            cnt = perft(th->rootPos, depth - 1);
+            th->rootPos.undo_move(m);
         }
-        if (Root)
-            sync_cout << UCI::move(m, pos.is_chess960()) << ": " << cnt << sync_endl;
+
+        perftMoves[i].second = cnt;
     }
-    return nodes;
   }
 
 } // namespace
@@ -167,13 +350,22 @@ void Search::clear() {
   Time.availableNodes = 0;
   TT.clear();
   Threads.clear();
-  Tablebases::init(Options["SyzygyPath"]); // Free mapped files
 
   Experience::save();
   Experience::resume_learning();
 }
 
 
+/// Search::set_batch_mode() is called before a batch analysis, in which the
+/// thread groups search different positions: the modes coordinating all the
+/// threads on the same root are turned off.
+
+void Search::set_batch_mode() {
+
+  UseABDADA = SplitMultiPV = false;
+}
+
+
 /// MainThread::search() is started when the program receives the UCI 'go'
 /// command. It searches from the root position and outputs the "bestmove".
 
@@ -181,8 +373,32 @@ void MainThread::search() {
 
   if (Limits.perft)
   {
-      nodes = perft<true>(rootPos, Limits.perft);
-      sync_cout << "\nNodes searched: " << nodes << "\n" << sync_endl;
+      TimePoint elapsed = now();
+
+      PerftTT.resize(size_t(Options["Perft Hash"]));
+      perftMoves.clear();
+      for (const auto& m : MoveList<LEGAL>(rootPos))
+          perftMoves.emplace_back(m, 0);
+      perftNext = 0;
+
+      Threads.start_searching(); // start non-main threads
+      perft_split(this, Limits.perft);
+      Threads.wait_for_search_finished();
+
+      elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+      // Report the leaf count as nodes searched, also for bench
+      for (Thread* th : Threads)
+          th->nodes = 0;
+
+      for (const auto& pm : perftMoves)
+      {
+          nodes += pm.second;
+          sync_cout << UCI::move(pm.first, rootPos.is_chess960()) << ": " << pm.second << sync_endl;
+      }
+
+      sync_cout << "\nNodes searched: " << nodes
+                << "\nNodes/second  : " << 1000 * nodes / elapsed << "\n" << sync_endl;
       return;
   }
 
@@ -193,6 +409,13 @@ void MainThread::search() {
   Time.init(Limits, us, rootPos.game_ply());
   TT.new_search();
 
+  UseABDADA = Options["SMP Mode"] == "ABDADA" && Threads.size() > 1;
+
+  SplitMultiPV =  Options["MultiPV Split"]
+               && Threads.size() > 1
+               && std::min(size_t(Options["MultiPV"]), rootMoves.size()) > 1;
+  PVLines.lines.assign(rootMoves.size(), RootMove(MOVE_NONE));
+
   Eval::init(true);
 
   Move bookMove = MOVE_NONE;
@@ -310,10 +533,11 @@ void MainThread::search() {
   // Threads.stop. However, if we are pondering or in an infinite search,
   // the UCI protocol states that we shouldn't print the best move before the
   // GUI sends a "stop" or "ponderhit" command. We therefore simply wait here
-  // until the GUI sends one of those commands.
-
-  while (!Threads.stop && (ponder || Limits.infinite))
-  {} // Busy wait for a stop or a ponder reset
+  // until the GUI sends one of those commands, see MainThread::wake_up().
+  {
+      std::unique_lock<std::mutex> lk(waitMutex);
+      waitCv.wait(lk, [&]{ return Threads.stop || !(ponder || Limits.infinite); });
+  }
 
   // Stop the threads if not already stopped (also raise the stop if
   // "ponderhit" just reset Threads.ponder).
@@ -322,6 +546,10 @@ void MainThread::search() {
   // Wait until all threads have finished
   Threads.wait_for_search_finished();
 
+  // Collect the lines searched by the helper threads
+  if (SplitMultiPV && rootMoves[0].pv[0] != MOVE_NONE)
+      adopt_lines(rootMoves);
+
   // When playing in 'nodes as time' mode, subtract the searched nodes from
   // the available ones before exiting.
   if (Limits.npmsec)
@@ -335,6 +563,12 @@ void MainThread::search() {
       && rootMoves[0].pv[0] != MOVE_NONE)
       bestThread = Threads.get_best_thread();
 
+  // Collect the results of the cluster workers, the deepest one is played
+  bool clusterBest = Cluster::finish(bestThread,    bookMove == MOVE_NONE
+                                                 && int(Options["MultiPV"]) == 1
+                                                 && !(Skill(Options["Skill Level"]).enabled() || int(Options["UCI_LimitStrength"]))
+                                                 && rootMoves[0].pv[0] != MOVE_NONE);
+
   if (    bookMove == MOVE_NONE
       && !Experience::is_learning_paused()
       && !bestThread->rootPos.is_chess960()
@@ -402,7 +636,7 @@ void MainThread::search() {
   bestPreviousScore = bestThread->rootMoves[0].score;
 
   // Send again PV info if we have a new best thread
-  if (bestThread != this)
+  if (bestThread != this || clusterBest)
       sync_cout << UCI::pv(bestThread->rootPos, bestThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE) << sync_endl;
 
   sync_cout << "bestmove " << UCI::move(bestThread->rootMoves[0].pv[0], rootPos.is_chess960());
@@ -420,6 +654,13 @@ void MainThread::search() {
 
 void Thread::search() {
 
+  // Helper threads share the root moves of a perft with the main thread
+  if (Limits.perft)
+  {
+      perft_split(this, Limits.perft);
+      return;
+  }
+
   // To allow access to (ss-7) up to (ss+2), the stack must be oversized.
   // The former is needed to allow update_continuation_histories(ss-1, ...),
   // which accesses its argument at ss-6, also near the root.
@@ -429,7 +670,7 @@ void Thread::search() {
   Value bestValue, alpha, beta, delta;
   Move  lastBestMove = MOVE_NONE;
   Depth lastBestMoveDepth = 0;
-  MainThread* mainThread = (this == Threads.main() ? Threads.main() : nullptr);
+  MainThread* mainThread = (this == Threads.main() && !group ? Threads.main() : nullptr);
   double timeReduction = 1, totBestMoveChanges = 0;
   Color us = rootPos.side_to_move();
   int iterIdx = 0;
@@ -488,13 +729,17 @@ void Thread::search() {
 
   // Iterative deepening loop until requested to stop or the target depth is reached
   while (   ++rootDepth < MAX_PLY
-         && !Threads.stop
-         && !(Limits.depth && mainThread && rootDepth > Limits.depth))
+         && !*stop
+         && !(Limits.depth && (mainThread || group) && rootDepth > Limits.depth))
   {
       // Age out PV variability metric
       if (mainThread)
           totBestMoveChanges /= 2;
 
+      // Start from the lines searched so far by all the threads
+      if (SplitMultiPV)
+          adopt_lines(rootMoves);
+
       // Save the last iteration's scores before first PV line is searched and
       // all the move scores except the (new) PV are set to -VALUE_INFINITE.
       for (RootMove& rm : rootMoves)
@@ -507,7 +752,7 @@ void Thread::search() {
          searchAgainCounter++;
 
       // MultiPV loop. We perform a full root search for each PV line
-      for (pvIdx = 0; pvIdx < multiPV && !Threads.stop; ++pvIdx)
+      for (pvIdx = 0; pvIdx < multiPV && !*stop; ++pvIdx)
       {
           if (pvIdx == pvLast)
           {
@@ -517,6 +762,10 @@ void Thread::search() {
                       break;
           }
 
+          // Leave the lines of the other threads to them
+          if (SplitMultiPV && !owns_line(id(), pvIdx, multiPV))
+              continue;
+
           // Reset UCI info selDepth for each depth and each PV line
           selDepth = 0;
 
@@ -555,7 +804,7 @@ void Thread::search() {
               // If search has been stopped, we break immediately. Sorting is
               // safe because RootMoves is still valid, although it refers to
               // the previous iteration.
-              if (Threads.stop)
+              if (*stop)
                   break;
 
               // When failing high/low give some update (without cluttering
@@ -590,15 +839,29 @@ void Thread::search() {
               assert(alpha >= -VALUE_INFINITE && beta <= VALUE_INFINITE);
           }
 
+          if (SplitMultiPV && !*stop)
+              publish_line(pvIdx, rootMoves[pvIdx], rootDepth);
+
           // Sort the PV lines searched so far and update the GUI
           std::stable_sort(rootMoves.begin() + pvFirst, rootMoves.begin() + pvIdx + 1);
 
           if (    mainThread
-              && (Threads.stop || pvIdx + 1 == multiPV || Time.elapsed() > 3000))
+              && !SplitMultiPV
+              && (*stop || pvIdx + 1 == multiPV || Time.elapsed() > 3000))
               sync_cout << UCI::pv(rootPos, rootDepth, alpha, beta) << sync_endl;
       }
 
-      if (!Threads.stop)
+      // Report the lines merged from all the threads
+      if (mainThread && SplitMultiPV)
+      {
+          if (!*stop)
+              adopt_lines(rootMoves);
+
+          pvIdx = multiPV; // No bound flag, lines come from different searches
+          sync_cout << UCI::pv(rootPos, rootDepth, -VALUE_INFINITE, VALUE_INFINITE) << sync_endl;
+      }
+
+      if (!*stop)
           completedDepth = rootDepth;
 
       if (rootMoves[0].pv[0] != lastBestMove) {
@@ -607,14 +870,14 @@ void Thread::search() {
       }
 	  // Limits the search depth to UCI user input // Works with 2 new ucioption.cpp variables
 	 if (  (Options["UCI_AnalyseMode"] && (rootDepth >= (Options["UCI_depthLimit"])))
-		|| (Threads.nodes_searched() >= (Options["UCI_knodeLimit"])*1000 && (completedDepth = rootDepth)) )
-	 	Threads.stop = true;  
+		|| ((group ? group->nodes_searched() : Threads.nodes_searched()) >= (Options["UCI_knodeLimit"])*1000 && (completedDepth = rootDepth)) )
+	 	*stop = true;  
 	 
       // Have we found a "mate in x"?
       if (   Limits.mate
           && bestValue >= VALUE_MATE_IN_MAX_PLY
           && VALUE_MATE - bestValue <= 2 * Limits.mate)
-          Threads.stop = true;
+          *stop = true;
 
       if (!mainThread)
           continue;
@@ -625,7 +888,7 @@ void Thread::search() {
 
       // Do we have time for the next iteration? Can we stop searching now?
       if (    Limits.use_time_management()
-          && !Threads.stop
+          && !*stop
           && !mainThread->stopOnPonderhit)
       {
           double fallingEval = (318 + 6 * (mainThread->bestPreviousScore - bestValue)
@@ -659,7 +922,7 @@ void Thread::search() {
               if (mainThread->ponder)
                   mainThread->stopOnPonderhit = true;
               else
-                  Threads.stop = true;
+                  *stop = true;
           }
           else if (   Threads.increaseDepth
                    && !mainThread->ponder
@@ -719,7 +982,6 @@ namespace {
 
     Move pv[MAX_PLY+1], capturesSearched[32], quietsSearched[64];
     StateInfo st;
-    ASSERT_ALIGNED(&st, Eval::NNUE::CacheLineSize);
 
     TTEntry* tte;
     Key posKey;
@@ -741,8 +1003,10 @@ namespace {
     bestValue          = -VALUE_INFINITE;
     maxValue           = VALUE_INFINITE;
 
-    // Check for the available remaining time
-    if (thisThread == Threads.main())
+    // Check for the available remaining time, or the nodes of a batch analysis
+    if (thisThread->group)
+        thisThread->group->check_limits(thisThread);
+    else if (thisThread == Threads.main())
         static_cast<MainThread*>(thisThread)->check_time();
 
     // Used to send selDepth info to GUI (selDepth counts from 1, ply from 0)
@@ -752,7 +1016,7 @@ namespace {
     if (!rootNode)
     {
         // Step 2. Check for aborted search and immediate draw
-        if (   Threads.stop.load(std::memory_order_relaxed)
+        if (   thisThread->stop->load(std::memory_order_relaxed)
             || pos.is_draw(ss->ply)
             || ss->ply >= MAX_PLY)
             return (ss->ply >= MAX_PLY && !ss->inCheck) ? evaluate(pos)
@@ -1184,9 +1448,18 @@ moves_loop: // When in check, search starts here
                          && (tte->bound() & BOUND_UPPER)
                          && tte->depth() >= depth;
 
+    // With ABDADA work sharing, moves being searched by another thread are
+    // deferred, and searched once the move picker has run out of moves. The
+    // first move is never deferred, as its score is needed for the others.
+    const bool shareWork = UseABDADA && !rootNode && depth >= SearchingTable::MinDepth;
+    Move deferredMoves[32];
+    int deferredCount = 0, deferredIdx = 0;
+    Key moveKey = 0;
+
     // Step 12. Loop through all pseudo-legal moves until no moves remain
     // or a beta cutoff occurs.
-    while ((move = mp.next_move(moveCountPruning)) != MOVE_NONE)
+    while (   (move = mp.next_move(moveCountPruning)) != MOVE_NONE
+           || (deferredIdx < deferredCount && (move = deferredMoves[deferredIdx++]) != MOVE_NONE))
     {
       assert(is_ok(move));
 
@@ -1205,9 +1478,23 @@ moves_loop: // When in check, search starts here
       if (!rootNode && !pos.legal(move))
           continue;
 
+      if (shareWork)
+      {
+          moveKey = SearchingTable::move_key(pos, move);
+
+          if (   moveCount
+              && !deferredIdx
+              && deferredCount < 32
+              && Searching.busy(moveKey))
+          {
+              deferredMoves[deferredCount++] = move;
+              continue;
+          }
+      }
+
       ss->moveCount = ++moveCount;
 
-      if (rootNode && thisThread == Threads.main() && Time.elapsed() > 3000)
+      if (rootNode && thisThread == Threads.main() && !thisThread->group && Time.elapsed() > 3000)
           sync_cout << "info depth " << depth
                     << " currmove " << UCI::move(move, pos.is_chess960())
                     << " currmovenumber " << moveCount + thisThread->pvIdx << sync_endl;
@@ -1347,6 +1634,9 @@ moves_loop: // When in check, search starts here
                                                                 [to_sq(move)];
 
       // Step 15. Make the move
+      if (shareWork)
+          Searching.start(moveKey);
+
       pos.do_move(move, st, givesCheck);
 
       // Step 16. Late moves reduction / extension (LMR, ~200 Elo)
@@ -1452,13 +1742,16 @@ moves_loop: // When in check, search starts here
       // Step 18. Undo move
       pos.undo_move(move);
 
+      if (shareWork)
+          Searching.finish(moveKey);
+
       assert(value > -VALUE_INFINITE && value < VALUE_INFINITE);
 
       // Step 19. Check for a new best move
       // Finished searching the move. If a stop occurred, the return value of
       // the search cannot be trusted, and we return immediately without
       // updating best move, PV and TT.
-      if (Threads.stop.load(std::memory_order_relaxed))
+      if (thisThread->stop->load(std::memory_order_relaxed))
           return VALUE_ZERO;
 
       if (rootNode)
@@ -1566,11 +1859,19 @@ moves_loop: // When in check, search starts here
 
     // Write gathered information in transposition table
     if (!excludedMove && !(rootNode && thisThread->pvIdx))
-        tte->save(posKey, value_to_tt(bestValue, ss->ply), ss->ttPv,
-                  bestValue >= beta ? BOUND_LOWER :
-                  PvNode && bestMove ? BOUND_EXACT : BOUND_UPPER,
+    {
+        Bound b =  bestValue >= beta ? BOUND_LOWER :
+                   PvNode && bestMove ? BOUND_EXACT : BOUND_UPPER;
+
+        tte->save(posKey, value_to_tt(bestValue, ss->ply), ss->ttPv, b,
                   depth, bestMove, ss->staticEval);
 
+        // Send the deep entries to the other processes of a cluster
+        if (Cluster::should_share(PvNode, depth))
+            Cluster::share(posKey, value_to_tt(bestValue, ss->ply), ss->ttPv, b,
+                           depth, bestMove, ss->staticEval);
+    }
+
     assert(bestValue > -VALUE_INFINITE && bestValue < VALUE_INFINITE);
 
     return bestValue;
@@ -1591,7 +1892,6 @@ moves_loop: // When in check, search starts here
 
     Move pv[MAX_PLY+1];
     StateInfo st;
-    ASSERT_ALIGNED(&st, Eval::NNUE::CacheLineSize);
 
     TTEntry* tte;
     Key posKey;
@@ -2012,6 +2312,10 @@ void MainThread::check_time() {
       dbg_print();
   }
 
+  // Store the TT entries received from the other processes of the cluster
+  if (Cluster::Sharing.load(std::memory_order_relaxed))
+      Cluster::apply();
+
   // We should not stop pondering until told so by the GUI
   if (ponder)
       return;
@@ -2046,6 +2350,10 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
       Depth d = updated ? depth : std::max(1, depth - 1);
       Value v = updated ? rootMoves[i].score : rootMoves[i].previousScore;
 
+      // Lines searched by other threads have their own depth
+      if (SplitMultiPV && updated)
+          d = rootMoves[i].lineDepth;
+
       if (v == -VALUE_INFINITE)
           v = VALUE_ZERO;
 
@@ -2093,7 +2401,6 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
 bool RootMove::extract_ponder_from_tt(Position& pos) {
 
     StateInfo st;
-    ASSERT_ALIGNED(&st, Eval::NNUE::CacheLineSize);
 
     bool ttHit;
 
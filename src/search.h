@@ -73,8 +73,9 @@ struct RootMove {
   Value score = -VALUE_INFINITE;
   Value previousScore = -VALUE_INFINITE;
   int selDepth = 0;
+  Depth lineDepth = 0; // Depth the PV line was searched at, for MultiPV split
   int tbRank = 0;
-  Value tbScore;
+  Value tbScore = VALUE_ZERO;
   std::vector<Move> pv;
 };
 
@@ -106,6 +107,7 @@ extern LimitsType Limits;
 
 void init();
 void clear();
+void set_batch_mode();
 
 } // namespace Search
 
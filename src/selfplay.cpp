@@ -0,0 +1,297 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "analysis.h"
+#include "experience.h"
+#include "movegen.h"
+#include "position.h"
+#include "selfplay.h"
+#include "thread.h"
+#include "uci.h"
+
+using std::string;
+
+namespace Stockfish::SelfPlay {
+
+namespace {
+
+  const string StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+  // Adjudication: a game is won when the scores of both sides agree on the
+  // winner for ResignPlies plies in a row, and drawn after DrawPly plies when
+  // they stay close to zero for DrawPlies plies in a row.
+  constexpr Value ResignScore = Value(1000);
+  constexpr Value DrawScore   = Value(10);
+  constexpr int ResignPlies = 6, DrawPlies = 8, DrawPly = 80;
+
+  // A move played with enough depth, added to the experience after the run
+  struct Record {
+    Key key;
+    Move move;
+    Value value;
+    Depth depth;
+  };
+
+  std::vector<Analysis::Entry> Openings;
+  size_t Games;
+  int RandomPlies, MaxPly;
+  uint64_t Seed;
+  std::ofstream Pgn;
+
+  std::atomic<size_t> NextGame;
+  std::mutex ResultsMutex;
+  std::vector<Record> Records;
+  size_t Results[COLOR_NB + 1]; // Indexed by the winner, COLOR_NB for a draw
+  uint64_t TotalPlies;
+  std::atomic<uint64_t> TotalNodes;
+
+
+  // insufficient_material() tells whether none of the sides can mate
+  bool insufficient_material(const Position& pos) {
+
+    return   pos.count<ALL_PIECES>() == 2
+          || (pos.count<ALL_PIECES>() == 3 && pos.count<KNIGHT>() + pos.count<BISHOP>() == 1);
+  }
+
+
+  // play() is the driver of a self-play run: the groups play the games in turn
+  // until all of them have been played.
+
+  void play(Analysis::Group& g) {
+
+    Thread* leader = g.threads.front();
+    const bool chess960 = Options["UCI_Chess960"];
+
+    for (size_t idx; (idx = NextGame++) < Games; )
+    {
+        PRNG rng((Seed + idx) * 0x9E3779B97F4A7C15ULL | 1);
+        StateListPtr states(new std::deque<StateInfo>(1));
+        Position pos;
+
+        // The openings of the file are taken in turn, then random moves are played
+        pos.set(Openings.empty() ? StartFEN : Openings[idx % Openings.size()].fen,
+                chess960, &states->back(), leader);
+
+        for (int i = 0; i < RandomPlies; ++i)
+        {
+            MoveList<LEGAL> moves(pos);
+
+            if (!moves.size())
+                break;
+
+            states->emplace_back();
+            pos.do_move(*(moves.begin() + rng.rand<uint32_t>() % moves.size()), states->back());
+        }
+
+        const string startFen = pos.fen();
+        states = StateListPtr(new std::deque<StateInfo>(1));
+        pos.set(startFen, chess960, &states->back(), leader);
+
+        std::vector<Record> game;
+        string moves, termination;
+        Color winner = COLOR_NB;
+        int ply = 0, drawCnt = 0, resignCnt[COLOR_NB] = {};
+        bool learning = true;
+
+        while (true)
+        {
+            if (!MoveList<LEGAL>(pos).size())
+            {
+                winner = pos.checkers() ? ~pos.side_to_move() : COLOR_NB;
+                termination = pos.checkers() ? "checkmate" : "stalemate";
+                break;
+            }
+
+            if (pos.is_draw(0))
+            {
+                termination = pos.rule50_count() > 99 ? "fifty-moves" : "repetition";
+                break;
+            }
+
+            if (insufficient_material(pos))
+            {
+                termination = "material";
+                break;
+            }
+
+            if (resignCnt[WHITE] >= ResignPlies || resignCnt[BLACK] >= ResignPlies)
+            {
+                winner = resignCnt[WHITE] >= ResignPlies ? WHITE : BLACK;
+                termination = "adjudication";
+                break;
+            }
+
+            if ((ply >= DrawPly && drawCnt >= DrawPlies) || ply >= MaxPly)
+            {
+                termination = "adjudication";
+                break;
+            }
+
+            Thread* best = g.search(pos.fen(), &states->back(), ply == 0);
+            const Search::RootMove& rm = best->rootMoves[0];
+            Value v = rm.score != -VALUE_INFINITE ? rm.score : rm.previousScore;
+            Move m = rm.pv[0];
+
+            v = v == -VALUE_INFINITE ? VALUE_ZERO : v;
+            TotalNodes += g.nodes_searched();
+
+            // Scores and depths in the units read back by convert_compact_pgn
+            moves += "," + UCI::move(m, chess960) + ":" + std::to_string(v) + ":" + std::to_string(best->completedDepth);
+
+            // Learn until the game is decided, as in a game played through UCI
+            if (learning && best->completedDepth >= EXP_MIN_DEPTH)
+                game.push_back({ pos.key(), m, v, best->completedDepth });
+
+            learning = learning && !Utility::is_game_decided(pos, v);
+
+            Value whiteScore = pos.side_to_move() == WHITE ? v : -v;
+            resignCnt[WHITE] = whiteScore >=  ResignScore ? resignCnt[WHITE] + 1 : 0;
+            resignCnt[BLACK] = whiteScore <= -ResignScore ? resignCnt[BLACK] + 1 : 0;
+            drawCnt = std::abs(v) <= DrawScore ? drawCnt + 1 : 0;
+
+            states->emplace_back();
+            pos.do_move(m, states->back());
+            ++ply;
+        }
+
+        std::lock_guard<std::mutex> lk(ResultsMutex);
+
+        Records.insert(Records.end(), game.begin(), game.end());
+        ++Results[winner];
+        TotalPlies += ply;
+
+        if (Pgn.is_open() && ply)
+            Pgn << "{" << startFen << "," << "wbd"[winner] << moves << "}" << std::endl;
+
+        sync_cout << "selfplay " << idx + 1
+                  << " result " << (winner == WHITE ? "1-0" : winner == BLACK ? "0-1" : "1/2-1/2")
+                  << " termination " << termination
+                  << " plies " << ply << sync_endl;
+    }
+  }
+
+} // namespace
+
+
+/// SelfPlay::run() is called when engine receives the "selfplay" command:
+///
+///   selfplay [games <n>] [depth <d>] [nodes <n>] [movetime <ms>] [slots <k>]
+///            [openings <file>] [random <plies>] [maxply <p>] [pgn <file>]
+///
+/// The games, 100 by default, start from the positions of the openings file
+/// taken in turn, or from the start position, followed by random moves (2 by
+/// default without an openings file). Each move is searched to the given depth
+/// (9 by default), number of nodes or time, k games being played at a time by
+/// k groups sharing out the threads. The results are printed as the games end,
+/// then the moves are added to the experience file and a summary follows on
+/// stderr.
+
+void run(std::istream& args) {
+
+  Search::LimitsType limits;
+  string token, pgnFile;
+  size_t slots = Threads.size();
+
+  Games = 100;
+  RandomPlies = -1;
+  MaxPly = 400;
+  Openings.clear();
+
+  while (args >> token)
+      if (token == "games")          args >> Games;
+      else if (token == "depth")     args >> limits.depth;
+      else if (token == "nodes")     args >> limits.nodes;
+      else if (token == "movetime")  args >> limits.movetime;
+      else if (token == "slots")     args >> slots;
+      else if (token == "random")    args >> RandomPlies;
+      else if (token == "maxply")    args >> MaxPly;
+      else if (token == "pgn")       args >> pgnFile;
+      else if (token == "openings")
+      {
+          args >> token;
+          if (!Analysis::read_positions(token, Openings))
+          {
+              sync_cout << "info string Could not open " << token << sync_endl;
+              return;
+          }
+      }
+
+  if (!limits.depth && !limits.nodes && !limits.movetime)
+      limits.depth = 9;
+
+  if (RandomPlies < 0)
+      RandomPlies = Openings.empty() ? 2 : 0;
+
+  if (!pgnFile.empty())
+  {
+      Pgn.open(pgnFile, std::ios::app);
+      if (!Pgn.is_open())
+      {
+          sync_cout << "info string Could not open " << pgnFile << sync_endl;
+          return;
+      }
+  }
+
+  Seed = uint64_t(now());
+  NextGame = 0;
+  Records.clear();
+  std::fill_n(Results, COLOR_NB + 1, 0);
+  TotalPlies = TotalNodes = 0;
+  TimePoint elapsed = now();
+
+  Analysis::start(slots, limits, play);
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+  Pgn.close();
+
+  // The experience is not thread safe, so it is only updated once all the
+  // threads are idle again.
+  size_t learnt = 0;
+
+  if (   Experience::enabled()
+      && !(bool)Options["Experience Readonly"]
+      && !(bool)Options["UCI_Chess960"])
+  {
+      for (const Record& r : Records)
+          Experience::add_pv_experience(r.key, r.move, r.value, r.depth);
+
+      learnt = Records.size();
+
+      Experience::save();
+  }
+
+  std::cerr << "\n==========================="
+            << "\nGames           : " << Games
+            << "\nWhite/Draw/Black: " << Results[WHITE] << "/" << Results[COLOR_NB] << "/" << Results[BLACK]
+            << "\nPlies           : " << TotalPlies
+            << "\nExperience moves: " << learnt
+            << "\nTotal time (ms) : " << elapsed
+            << "\nNodes searched  : " << TotalNodes
+            << "\nNodes/second    : " << 1000 * TotalNodes / elapsed
+            << "\nGames/hour      : " << 3600000 * Games / elapsed << std::endl;
+}
+
+} // namespace Stockfish::SelfPlay
@@ -0,0 +1,39 @@
+/*
+  SugaR, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2021 The Stockfish developers (see AUTHORS file)
+
+  SugaR is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SugaR is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELFPLAY_H_INCLUDED
+#define SELFPLAY_H_INCLUDED
+
+#include <istream>
+
+namespace Stockfish {
+
+/// The SelfPlay namespace plays games of the engine against itself, several at
+/// a time in the thread groups of a batch analysis. The moves feed the
+/// experience file and the games can be written in compact PGN, the format
+/// read by "convert_compact_pgn".
+
+namespace SelfPlay {
+
+void run(std::istream& args);
+
+} // namespace SelfPlay
+
+} // namespace Stockfish
+
+#endif // #ifndef SELFPLAY_H_INCLUDED
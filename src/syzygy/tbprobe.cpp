@@ -25,6 +25,7 @@
 #include <iostream>
 #include <list>
 #include <sstream>
+#include <thread>
 #include <type_traits>
 #include <mutex>
 
@@ -423,6 +424,7 @@ class TBTables {
 
     std::deque<TBTable<WDL>> wdlTable;
     std::deque<TBTable<DTZ>> dtzTable;
+    std::vector<std::string> wdlCode; // Material code, like "KRvK", of each wdlTable[]
 
     void insert(Key key, TBTable<WDL>* wdl, TBTable<DTZ>* dtz) {
         uint32_t homeBucket = (uint32_t)key & (Size - 1);
@@ -462,13 +464,30 @@ public:
         memset(hashTable, 0, sizeof(hashTable));
         wdlTable.clear();
         dtzTable.clear();
+        wdlCode.clear();
     }
     size_t size() const { return wdlTable.size(); }
     void add(const std::vector<PieceType>& pieces);
+    void warm_up(int maxPieces, const std::atomic_bool& stop);
 };
 
 TBTables TBTables;
 
+// WarmUp runs TBTables::warm_up() in the background. It is declared after
+// TBTables so that at exit the thread is stopped before the tables go away.
+struct WarmUp {
+    std::thread thread;
+    std::atomic_bool stop;
+
+    ~WarmUp() { cancel(); }
+
+    void cancel() {
+        stop = true;
+        if (thread.joinable())
+            thread.join();
+    }
+} WarmUp;
+
 // If the corresponding file exists two new objects TBTable<WDL> and TBTable<DTZ>
 // are created and added to the lists and hash table. Called at init time.
 void TBTables::add(const std::vector<PieceType>& pieces) {
@@ -489,6 +508,7 @@ void TBTables::add(const std::vector<PieceType>& pieces) {
 
     wdlTable.emplace_back(code);
     dtzTable.emplace_back(wdlTable.back());
+    wdlCode.push_back(code);
 
     // Insert into the hash keys for both colors: KRvK with KR white and black
     insert(wdlTable.back().key , &wdlTable.back(), &dtzTable.back());
@@ -1166,6 +1186,38 @@ void* mapped(TBTable<Type>& e, const Position& pos) {
     return e.baseAddress;
 }
 
+// Map the WDL tables with up to maxPieces pieces and fault their pages in, so
+// that the first probes of a search do not wait for the disk. Tables with less
+// pieces are the most probed ones, so they are done first. Returns early when
+// 'stop' is set.
+void TBTables::warm_up(int maxPieces, const std::atomic_bool& stop) {
+
+    for (int n = 3; n <= maxPieces; ++n)
+        for (size_t i = 0; i < wdlTable.size() && !stop; ++i)
+        {
+            TBTable<WDL>& e = wdlTable[i];
+
+            if (e.pieceCount != n)
+                continue;
+
+            StateInfo st;
+            Position pos;
+            pos.set(wdlCode[i], WHITE, &st);
+
+            if (!mapped(e, pos))
+                continue;
+
+#ifndef _WIN32
+            // Touch every page, 'mapping' is the file size on POSIX systems
+            const volatile uint8_t* data = (const uint8_t*)e.baseAddress;
+            uint8_t sum = 0;
+            for (uint64_t offset = 0; offset < e.mapping && !stop; offset += 4096)
+                sum += data[offset];
+            (void)sum;
+#endif
+        }
+}
+
 template<TBType Type, typename Ret = typename TBTable<Type>::Ret>
 Ret probe_table(const Position& pos, ProbeState* result, WDLScore wdl = WDLDraw) {
 
@@ -1258,11 +1310,16 @@ WDLScore search(Position& pos, ProbeState* result) {
 } // namespace
 
 
-/// Tablebases::init() is called at startup and after every change to
-/// "SyzygyPath" UCI option to (re)create the various tables. It is not thread
-/// safe, nor it needs to be.
+/// Tablebases::init() is called after every change to "SyzygyPath" UCI option
+/// to (re)create the various tables. Tables, and their memory mappings, are
+/// kept as long as the paths do not change, also across games. It is not
+/// thread safe, nor it needs to be.
 void Tablebases::init(const std::string& paths) {
 
+    if (paths == TBFile::Paths)
+        return;
+
+    WarmUp.cancel();
     TBTables.clear();
     MaxCardinality = 0;
     TBFile::Paths = paths;
@@ -1405,6 +1462,21 @@ void Tablebases::init(const std::string& paths) {
     sync_cout << "info string Found " << TBTables.size() << " tablebases" << sync_endl;
 }
 
+
+/// Tablebases::warm_up() starts mapping in the background the WDL tables with
+/// up to maxPieces pieces, see TBTables::warm_up(). A previous warm-up still
+/// running is stopped first. Zero disables it.
+void Tablebases::warm_up(int maxPieces) {
+
+    WarmUp.cancel();
+
+    if (maxPieces < 3 || !TBTables.size())
+        return;
+
+    WarmUp.stop = false;
+    WarmUp.thread = std::thread([maxPieces]() { TBTables.warm_up(maxPieces, WarmUp.stop); });
+}
+
 // Probe the WDL table for a particular position.
 // If *result != FAIL, the probe was successful.
 // The return value is from the point of view of the side to move:
@@ -46,6 +46,7 @@ enum ProbeState {
 extern int MaxCardinality;
 
 void init(const std::string& paths);
+void warm_up(int maxPieces);
 WDLScore probe_wdl(Position& pos, ProbeState* result);
 int probe_dtz(Position& pos, ProbeState* result);
 bool root_probe(Position& pos, Search::RootMoves& rootMoves);
@@ -19,6 +19,7 @@
 #include <cassert>
 
 #include <algorithm> // For std::count
+#include "analysis.h"
 #include "movegen.h"
 #include "search.h"
 #include "thread.h"
@@ -36,6 +37,7 @@ ThreadPool Threads; // Global object
 
 Thread::Thread(size_t n) : idx(n), stdThread(&Thread::idle_loop, this) {
 
+  stop = &Threads.stop;
   wait_for_search_finished();
 }
 
@@ -93,59 +95,121 @@ void Thread::wait_for_search_finished() {
 }
 
 
+/// Thread::start_clearing() wakes up the thread to reset its histories. This
+/// way the tables of all the threads are cleared in parallel, and each one is
+/// first touched by the thread that uses it.
+
+void Thread::start_clearing() {
+
+  std::lock_guard<std::mutex> lk(mutex);
+  clearing = searching = true;
+  cv.notify_one(); // Wake up the thread in idle_loop()
+}
+
+
+/// Thread::wait_for_clear() blocks until the histories have been reset. Unlike
+/// wait_for_search_finished() it returns immediately while searching.
+
+void Thread::wait_for_clear() {
+
+  std::unique_lock<std::mutex> lk(mutex);
+  cv.wait(lk, [&]{ return !clearing; });
+}
+
+
 /// Thread::idle_loop() is where the thread is parked, blocked on the
 /// condition variable, when it has no work to do.
 
 void Thread::idle_loop() {
 
-  // If OS already scheduled us on a different group than 0 then don't overwrite
-  // the choice, eventually we are one of many one-threaded processes running on
-  // some Windows NUMA hardware, for instance in fishtest. To make it simple,
-  // just check if running threads are below a threshold, in this case all this
-  // NUMA machinery is not needed.
-  if (Options["Threads"] > 8)
-      WinProcGroup::bindThisThread(idx);
+  // Bind the thread according to the "Thread Binding" option, see bind_mode()
+  WinProcGroup::bindThisThread(idx, Threads.bind_mode());
 
   while (true)
   {
       std::unique_lock<std::mutex> lk(mutex);
-      searching = false;
-      cv.notify_one(); // Wake up anyone waiting for search finished
+      searching = clearing = false;
+      cv.notify_all(); // Wake up anyone waiting for search or clear finished
       cv.wait(lk, [&]{ return searching; });
 
       if (exit)
           return;
 
+      const bool clearOnly = clearing;
+
       lk.unlock();
 
-      search();
+      if (clearOnly)
+          clear();
+      else if (group)
+          Analysis::work(this);
+      else
+          search();
   }
 }
 
+/// MainThread::wake_up() is called after raising Threads.stop or resetting
+/// ponder, to release the main thread if it is waiting for a "stop" or a
+/// "ponderhit" at the end of its search. Taking the mutex ensures that the
+/// notification cannot fall between the check of the condition and the wait.
+
+void MainThread::wake_up() {
+
+  std::lock_guard<std::mutex> lk(waitMutex);
+  waitCv.notify_one();
+}
+
+
 /// ThreadPool::set() creates/destroys threads to match the requested number.
 /// Created and launched threads will immediately go to sleep in idle_loop.
-/// Upon resizing, threads are recreated to allow for binding if necessary.
+/// Existing threads are kept, together with their histories, so that the pool
+/// can be resized between games at little cost. Threads are bound only when
+/// they are created, so all are recreated if the binding mode changes.
 
 void ThreadPool::set(size_t requested) {
 
-  if (size() > 0)   // destroy any existing thread(s)
+  if (size() > 0)
   {
       main()->wait_for_search_finished();
+      wait_for_clear();
+  }
 
+  const WinProcGroup::BindMode mode = bind_mode();
+  if (mode != bindMode)
+  {
       while (size() > 0)
           delete back(), pop_back();
+
+      bindMode = mode;
   }
 
+  while (size() > requested)   // destroy extra thread(s), main thread last
+      delete back(), pop_back();
+
   if (requested > 0)   // create new thread(s)
   {
-      push_back(new MainThread(0));
+      const size_t created = requested - size();
+
+      if (empty())
+      {
+          push_back(new MainThread(0));
+          clear();
+      }
 
       while (size() < requested)
+      {
           push_back(new Thread(size()));
-      clear();
+          back()->start_clearing();
+      }
+
+      // New threads bind themselves silently, report the binding once
+      if (created && mode != WinProcGroup::BindNone)
+          sync_cout << "info string Binding " << requested << " threads, "
+                    << (mode == WinProcGroup::BindCompact ? "compact" : "scatter") << sync_endl;
 
-      // Reallocate the hash with the new threadpool size
-      TT.resize(size_t(Options["Hash"]));
+      // The hash does not depend on the thread count, allocate it only if needed
+      if (!TT.memory() || TT.size_mb() != size_t(Options["Hash"]))
+          TT.resize(size_t(Options["Hash"]));
 
       // Init thread number dependent search params.
       Search::init();
@@ -153,12 +217,31 @@ void ThreadPool::set(size_t requested) {
 }
 
 
-/// ThreadPool::clear() sets threadPool data to initial values
+/// ThreadPool::bind_mode() translates the "Thread Binding" option. In auto
+/// mode threads are spread over the cores, caches and NUMA nodes only if more
+/// than 8 threads are used: we could be one of many one-threaded processes
+/// running on the same machine, for instance in fishtest, and then it is better
+/// to let the OS decide.
+
+WinProcGroup::BindMode ThreadPool::bind_mode() const {
+
+  return  Options["Thread Binding"] == "compact" ? WinProcGroup::BindCompact
+        : Options["Thread Binding"] == "scatter" ? WinProcGroup::BindScatter
+        : Options["Thread Binding"] == "auto" && Options["Threads"] > 8 ? WinProcGroup::BindScatter
+                                                                         : WinProcGroup::BindNone;
+}
+
+
+/// ThreadPool::clear() sets threadPool data to initial values. Histories are
+/// reset by each thread in its idle_loop(), use wait_for_clear() to wait for
+/// completion.
 
 void ThreadPool::clear() {
 
+  wait_for_clear();
+
   for (Thread* th : *this)
-      th->clear();
+      th->start_clearing();
 
   main()->callsCnt = 0;
   main()->bestPreviousScore = VALUE_INFINITE;
@@ -173,6 +256,7 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
                                 const Search::LimitsType& limits, bool ponderMode) {
 
   main()->wait_for_search_finished();
+  wait_for_clear();
 
   main()->stopOnPonderhit = stop = false;
   increaseDepth = true;
@@ -199,7 +283,8 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   // some StateInfo fields (previous, pliesFromNull, capturedPiece) that cannot
   // be deduced from a fen string, so set() clears them and they are set from
   // setupStates->back() later. The rootState is per thread, earlier states are shared
-  // since they are read-only.
+  // since they are read-only. The rootState takes the first entry of the accumulator
+  // stack of its thread again.
   for (Thread* th : *this)
   {
       th->nodes = th->tbHits = th->nmpMinPly = th->bestMoveChanges = 0;
@@ -207,6 +292,7 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
       th->rootMoves = rootMoves;
       th->rootPos.set(pos.fen(), pos.is_chess960(), &th->rootState, th);
       th->rootState = setupStates->back();
+      th->rootState.accumulator = th->accumulatorStack.push(nullptr, th->rootState.accumulatorId);
   }
 
   main()->start_searching();
@@ -263,4 +349,13 @@ void ThreadPool::wait_for_search_finished() const {
             th->wait_for_search_finished();
 }
 
+
+/// Wait for all threads to have reset their histories
+
+void ThreadPool::wait_for_clear() const {
+
+    for (Thread* th : *this)
+        th->wait_for_clear();
+}
+
 } // namespace Stockfish
@@ -34,6 +34,8 @@
 
 namespace Stockfish {
 
+namespace Analysis { struct Group; }
+
 /// Thread class keeps together all the thread-related stuff. We use
 /// per-thread pawn and material hash tables so that once we get a
 /// pointer to an entry its life time is unlimited and we don't have
@@ -44,7 +46,7 @@ class Thread {
   std::mutex mutex;
   std::condition_variable cv;
   size_t idx;
-  bool exit = false, searching = true; // Set before starting std::thread
+  bool exit = false, searching = true, clearing = false; // Set before starting std::thread
   NativeThread stdThread;
 
 public:
@@ -55,10 +57,14 @@ public:
   void idle_loop();
   void start_searching();
   void wait_for_search_finished();
+  void start_clearing();
+  void wait_for_clear();
   size_t id() const { return idx; }
 
   Pawns::Table pawnsTable;
   Material::Table materialTable;
+  Eval::NNUE::AccumulatorStack accumulatorStack;
+  Eval::NNUE::AccumulatorCache accumulatorCache;
   size_t pvIdx, pvLast;
   uint64_t ttHitAverage;
   int selDepth, nmpMinPly;
@@ -75,6 +81,8 @@ public:
   CapturePieceToHistory captureHistory;
   ContinuationHistory continuationHistory[2][2];
   Score trend;
+  std::atomic_bool* stop;                // Threads.stop, or the stop of its group
+  Analysis::Group* group = nullptr;      // Set during a batch analysis
 };
 
 
@@ -86,6 +94,7 @@ struct MainThread : public Thread {
 
   void search() override;
   void check_time();
+  void wake_up();
 
   double previousTimeReduction;
   Value bestPreviousScore;
@@ -93,6 +102,10 @@ struct MainThread : public Thread {
   int callsCnt;
   bool stopOnPonderhit;
   std::atomic_bool ponder;
+
+private:
+  std::mutex waitMutex; // Used to wait for "stop" or "ponderhit" without spinning
+  std::condition_variable waitCv;
 };
 
 
@@ -112,11 +125,14 @@ struct ThreadPool : public std::vector<Thread*> {
   Thread* get_best_thread() const;
   void start_searching();
   void wait_for_search_finished() const;
+  void wait_for_clear() const;
+  WinProcGroup::BindMode bind_mode() const;
 
   std::atomic_bool stop, increaseDepth;
 
 private:
   StateListPtr setupStates;
+  WinProcGroup::BindMode bindMode = WinProcGroup::BindNone; // Of the current threads
 
   uint64_t accumulate(std::atomic<uint64_t> Thread::* member) const {
 
@@ -16,6 +16,7 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <chrono>
 #include <cstring>   // For std::memset
 #include <iostream>
 #include <thread>
@@ -30,6 +31,21 @@ namespace Stockfish {
 
 TranspositionTable TT; // Our global transposition table
 
+namespace {
+
+  // Header at the start of a shared hash segment, the clusters follow it. The
+  // magic encodes the layout so that incompatible builds do not mix their data.
+  struct alignas(64) SharedHeader {
+    std::atomic<uint64_t> magic;
+    uint64_t clusterCount;
+    std::atomic<uint8_t> generation8;
+  };
+
+  constexpr uint64_t SharedMagic = 0x5375674152545400ULL | 1; // "SugARTT", version 1
+
+  static_assert(sizeof(SharedHeader) == 64, "Unexpected SharedHeader size");
+}
+
 /// TTEntry::save() populates the TTEntry with a new node's data, possibly
 /// overwriting an old position. Update is not atomic and can be racy.
 
@@ -49,7 +65,7 @@ void TTEntry::save(Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev)
 
       key16     = (uint16_t)k;
       depth8    = (uint8_t)(d - DEPTH_OFFSET);
-      genBound8 = (uint8_t)(TT.generation8 | uint8_t(pv) << 2 | b);
+      genBound8 = (uint8_t)(TT.generation() | uint8_t(pv) << 2 | b);
       value16   = (int16_t)v;
       eval16    = (int16_t)ev;
   }
@@ -59,16 +75,26 @@ void TTEntry::save(Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev)
 /// TranspositionTable::resize() sets the size of the transposition table,
 /// measured in megabytes. Transposition table consists of a power of 2 number
 /// of clusters and each cluster consists of ClusterSize number of TTEntry.
+/// The kind of memory pages used is selected by the "Large Pages" option, unless
+/// the table is shared with other processes through "Hash Shared Name".
 
 void TranspositionTable::resize(size_t mbSize) {
 
   Threads.main()->wait_for_search_finished();
 
-  aligned_large_pages_free(table);
+  free();
+
+  sizeMB = mbSize;
+
+  std::string name = Options["Hash Shared Name"];
+  if (!name.empty() && name != "<empty>" && attach_shared(name, mbSize))
+      return;
 
   clusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
 
-  table = static_cast<Cluster*>(aligned_large_pages_alloc(clusterCount * sizeof(Cluster)));
+  const size_t pageSize = UCI::large_page_size();
+
+  table = static_cast<Cluster*>(aligned_large_pages_alloc(clusterCount * sizeof(Cluster), pageSize));
   if (!table)
   {
       std::cerr << "Failed to allocate " << mbSize
@@ -76,29 +102,134 @@ void TranspositionTable::resize(size_t mbSize) {
       exit(EXIT_FAILURE);
   }
 
-  clear();
+  // Report what we actually got when explicit huge pages were requested
+  if (pageSize > 4096)
+      sync_cout << "info string Hash " << mbSize << "MB allocated with "
+                << large_pages_info(table) << sync_endl;
+
+  // Fresh memory holds garbage that could pass for current entries
+  zero();
+}
+
+
+/// TranspositionTable::attach_shared() maps the named shared segment, creating
+/// it with the requested size if no other process did so already. A process
+/// that joins an existing segment keeps the size of the segment, whatever its
+/// own Hash value, and reports it. Returns false, and a private table is then
+/// allocated, if the segment cannot be mapped or does not hold a hash table
+/// whose clusters fit in it.
+
+bool TranspositionTable::attach_shared(const std::string& name, size_t mbSize) {
+
+  size_t size = sizeof(SharedHeader) + mbSize * 1024 * 1024;
+  bool created;
+
+  void* mem = shared_memory_map(name, size, created);
+  if (!mem)
+  {
+      sync_cout << "info string Cannot map shared hash '" << name
+                << "', using a private table" << sync_endl;
+      return false;
+  }
+
+  SharedHeader* header = static_cast<SharedHeader*>(mem);
+
+  if (created)
+  {
+      // The OS hands out zeroed memory, that is an empty table of generation 0
+      header->clusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
+      header->magic.store(SharedMagic, std::memory_order_release);
+  }
+  else
+  {
+      // The creator may still be filling in the header
+      for (int i = 0; i < 1000 && !header->magic.load(std::memory_order_acquire); ++i)
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+      if (   header->magic.load(std::memory_order_acquire) != SharedMagic
+          || sizeof(SharedHeader) + header->clusterCount * sizeof(Cluster) > size)
+      {
+          shared_memory_unmap(mem, size);
+          sync_cout << "info string Shared hash '" << name
+                    << "' is incompatible, using a private table" << sync_endl;
+          return false;
+      }
+  }
+
+  sharedMem = mem;
+  sharedSize = size;
+  clusterCount = header->clusterCount;
+  table = reinterpret_cast<Cluster*>(header + 1);
+  generationPtr = &header->generation8;
+  epoch16 = 0; // The clusters of a shared table are never reset by clear()
+
+  const size_t sharedMB = clusterCount * sizeof(Cluster) / (1024 * 1024);
+
+  sync_cout << "info string Hash " << sharedMB << "MB "
+            << (created ? "created" : "joined") << " as shared '" << name << "'";
+  if (sharedMB != mbSize)
+      std::cout << " instead of " << mbSize << "MB";
+  std::cout << sync_endl;
+
+  return true;
+}
+
+
+/// TranspositionTable::free() releases the table memory, be it private or shared.
+
+void TranspositionTable::free() {
+
+  if (sharedMem)
+      shared_memory_unmap(sharedMem, sharedSize);
+  else
+      aligned_large_pages_free(table);
+
+  table = nullptr;
+  sharedMem = nullptr;
+  generationPtr = &localGeneration8;
 }
 
 
-/// TranspositionTable::clear() initializes the entire transposition table to zero,
-//  in a multi-threaded way.
+/// TranspositionTable::clear() empties the table. Instead of zeroing the whole
+/// table, which takes seconds with a large hash, the epoch is advanced: probe()
+/// treats the clusters of other epochs as empty and resets them when it meets
+/// them. When the 16-bit epoch wraps the table is zeroed, so that a cluster left
+/// untouched for 65536 clears cannot pass for a current one.
 
 void TranspositionTable::clear() {
 
+  // Other processes may be using a shared table, so do not wipe their entries:
+  // advancing the generation is enough to make ours the preferred ones.
+  if (sharedMem)
+  {
+      new_search();
+      return;
+  }
+
+  if (++epoch16 == 0)
+      zero();
+}
+
+
+/// TranspositionTable::zero() sets the entire transposition table to zero, in a
+/// multi-threaded way, and restarts the epochs.
+
+void TranspositionTable::zero() {
+
   std::vector<std::thread> threads;
+  const size_t threadCount = size_t(Options["Threads"]);
 
-  for (size_t idx = 0; idx < Options["Threads"]; ++idx)
+  for (size_t idx = 0; idx < threadCount; ++idx)
   {
-      threads.emplace_back([this, idx]() {
+      threads.emplace_back([this, idx, threadCount]() {
 
           // Thread binding gives faster search on systems with a first-touch policy
-          if (Options["Threads"] > 8)
-              WinProcGroup::bindThisThread(idx);
+          WinProcGroup::bindThisThread(idx, Threads.bind_mode());
 
           // Each thread will zero its part of the hash table
-          const size_t stride = size_t(clusterCount / Options["Threads"]),
+          const size_t stride = size_t(clusterCount / threadCount),
                        start  = size_t(stride * idx),
-                       len    = idx != Options["Threads"] - 1 ?
+                       len    = idx != threadCount - 1 ?
                                 stride : clusterCount - start;
 
           std::memset(&table[start], 0, len * sizeof(Cluster));
@@ -107,6 +238,18 @@ void TranspositionTable::clear() {
 
   for (std::thread& th : threads)
       th.join();
+
+  epoch16 = 0;
+}
+
+
+/// TranspositionTable::new_search() advances the generation. Lower bits are used
+/// for other things. With a shared table several processes may advance the
+/// generation at the same time, hence the atomic add.
+
+void TranspositionTable::new_search() {
+
+  generationPtr->fetch_add(GENERATION_DELTA, std::memory_order_relaxed);
 }
 
 
@@ -119,8 +262,18 @@ void TranspositionTable::clear() {
 
 TTEntry* TranspositionTable::probe(const Key key, bool& found) const {
 
-  TTEntry* const tte = first_entry(key);
+  Cluster* const cl = &table[mul_hi64(key, clusterCount)];
+  TTEntry* const tte = &cl->entry[0];
   const uint16_t key16 = (uint16_t)key;  // Use the low 16 bits as key inside the cluster
+  const uint8_t generation8 = generation();
+
+  // The cluster was last written before clear(), its entries are empty
+  if (cl->epoch != epoch16)
+  {
+      for (int i = 0; i < ClusterSize; ++i)
+          tte[i] = TTEntry();
+      cl->epoch = epoch16;
+  }
 
   for (int i = 0; i < ClusterSize; ++i)
       if (tte[i].key16 == key16 || !tte[i].depth8)
@@ -151,10 +304,14 @@ TTEntry* TranspositionTable::probe(const Key key, bool& found) const {
 
 int TranspositionTable::hashfull() const {
 
+  const uint8_t generation8 = generation();
+
   int cnt = 0;
   for (int i = 0; i < 1000; ++i)
       for (int j = 0; j < ClusterSize; ++j)
-          cnt += table[i].entry[j].depth8 && (table[i].entry[j].genBound8 & GENERATION_MASK) == generation8;
+          cnt +=  table[i].epoch == epoch16
+                && table[i].entry[j].depth8
+                && (table[i].entry[j].genBound8 & GENERATION_MASK) == generation8;
 
   return cnt / ClusterSize;
 }
@@ -19,6 +19,9 @@
 #ifndef TT_H_INCLUDED
 #define TT_H_INCLUDED
 
+#include <atomic>
+#include <string>
+
 #include "misc.h"
 #include "types.h"
 
@@ -62,6 +65,16 @@ private:
 /// contains information on exactly one position. The size of a Cluster should
 /// divide the size of a cache line for best performance, as the cacheline is
 /// prefetched when possible.
+///
+/// Clearing the table does not touch the memory: clear() advances the epoch of
+/// the table and probe() empties the clusters of older epochs when it meets them,
+/// so that ucinewgame returns at once even with a large table.
+///
+/// If the "Hash Shared Name" option is set, the table lives in a named shared
+/// memory segment so that several engine processes on the same host share one
+/// lock-free table. The generation is then stored in the segment as well, and
+/// it is advanced atomically so that concurrent new_search() calls never lose
+/// an increment.
 
 class TranspositionTable {
 
@@ -69,7 +82,7 @@ class TranspositionTable {
 
   struct Cluster {
     TTEntry entry[ClusterSize];
-    char padding[2]; // Pad to 32 bytes
+    uint16_t epoch; // Epoch of the entries, also pads to 32 bytes
   };
 
   static_assert(sizeof(Cluster) == 32, "Unexpected Cluster size");
@@ -81,13 +94,17 @@ class TranspositionTable {
   static constexpr int      GENERATION_MASK  = (0xFF << GENERATION_BITS) & 0xFF; // mask to pull out generation number
 
 public:
- ~TranspositionTable() { aligned_large_pages_free(table); }
-  void new_search() { generation8 += GENERATION_DELTA; } // Lower bits are used for other things
+ ~TranspositionTable() { free(); }
+  void new_search();
   TTEntry* probe(const Key key, bool& found) const;
   int hashfull() const;
   void resize(size_t mbSize);
   void clear();
 
+  void* memory() const { return table; }
+  size_t size_mb() const { return sizeMB; }
+  bool is_shared() const { return sharedMem != nullptr; }
+
   TTEntry* first_entry(const Key key) const {
     return &table[mul_hi64(key, clusterCount)].entry[0];
   }
@@ -95,9 +112,20 @@ public:
 private:
   friend struct TTEntry;
 
+  void free();
+  void zero();
+  bool attach_shared(const std::string& name, size_t mbSize);
+
+  uint8_t generation() const { return generationPtr->load(std::memory_order_relaxed); }
+
   size_t clusterCount;
+  size_t sizeMB = 0; // As requested to resize()
   Cluster* table;
-  uint8_t generation8; // Size must be not bigger than TTEntry::genBound8
+  std::atomic<uint8_t> localGeneration8; // Size must be not bigger than TTEntry::genBound8
+  std::atomic<uint8_t>* generationPtr = &localGeneration8; // Points into the segment if shared
+  void* sharedMem = nullptr;
+  size_t sharedSize = 0;
+  uint16_t epoch16 = 0; // Advanced by clear(), 0 for a shared table
 };
 
 extern TranspositionTable TT;
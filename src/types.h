@@ -35,6 +35,10 @@
 ///
 /// -DUSE_PEXT    | Add runtime support for use of pext asm-instruction. Works
 ///               | only in 64-bit mode and requires hardware with pext support.
+///
+/// -DUSE_FAT_BINARY | Check the CPU at startup for popcnt and pext, and select the
+///                  | NNUE code built for its instruction set. Needs gcc or clang
+///                  | on x86-64, and the Makefile to build the NNUE variants.
 
 #include <cassert>
 #include <cctype>
@@ -79,12 +83,23 @@
 #if defined(USE_PEXT)
 #  include <immintrin.h> // Header for _pext_u64() intrinsic
 #  define pext(b, m) _pext_u64(b, m)
+#elif defined(USE_FAT_BINARY)
+// The instruction is assembled whatever the target, it is run only if HasPext
+inline uint64_t pext(uint64_t b, uint64_t m) {
+  asm("pextq %2, %1, %0" : "=r" (b) : "r" (b), "r" (m));
+  return b;
+}
 #else
 #  define pext(b, m) 0
 #endif
 
 namespace Stockfish {
 
+#if defined(USE_FAT_BINARY)
+extern const bool HasPopCnt; // Set at startup from the CPU, see bitboard.cpp
+extern const bool HasPext;
+#else
+
 #ifdef USE_POPCNT
 constexpr bool HasPopCnt = true;
 #else
@@ -97,6 +112,8 @@ constexpr bool HasPext = true;
 constexpr bool HasPext = false;
 #endif
 
+#endif
+
 #ifdef IS_64BIT
 constexpr bool Is64Bit = true;
 #else
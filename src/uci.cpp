@@ -18,14 +18,19 @@
 
 #include <cassert>
 #include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <sstream>
 #include <string>
 
+#include "analysis.h"
+#include "cluster.h"
 #include "evaluate.h"
 #include "movegen.h"
 #include "position.h"
 #include "search.h"
+#include "selfplay.h"
 #include "thread.h"
 #include "timeman.h"
 #include "tt.h"
@@ -80,6 +85,8 @@ namespace {
         pos.do_move(m, states->back());
     }
 
+    Cluster::position(is.str());
+
     static constexpr Key StartPosKey = 0xB4D30CD15A43432D;
     if (firstKey == StartPosKey && pos.game_ply() == 0)
         Experience::resume_learning();
@@ -118,7 +125,10 @@ namespace {
         value += (value.empty() ? "" : " ") + token;
 
     if (Options.count(name))
+    {
         Options[name] = value;
+        Cluster::forward_option(name, value);
+    }
     else
         sync_cout << "No such option: " << name << sync_endl;
   }
@@ -154,23 +164,30 @@ namespace {
         else if (token == "infinite")  limits.infinite = 1;
         else if (token == "ponder")    ponderMode = true;
 
+    // The workers of a cluster join once the previous search is over
+    if (!limits.perft)
+    {
+        Threads.main()->wait_for_search_finished();
+        Cluster::start(is.str());
+    }
+
     Threads.start_thinking(pos, states, limits, ponderMode);
   }
 
 
-  // bench() is called when engine receives the "bench" command. Firstly
-  // a list of UCI commands is setup according to bench parameters, then
-  // it is run one by one printing a summary at the end.
+  // run_bench() runs the list of UCI commands built by setup_bench() and
+  // returns the total nodes searched and the elapsed time.
 
-  void bench(Position& pos, istream& args, StateListPtr& states) {
+  void run_bench(Position& pos, const vector<string>& list, StateListPtr& states,
+                 uint64_t& nodes, TimePoint& elapsed) {
 
     string token;
-    uint64_t num, nodes = 0, cnt = 1;
+    uint64_t num, cnt = 1;
 
-    vector<string> list = setup_bench(pos, args);
     num = count_if(list.begin(), list.end(), [](string s) { return s.find("go ") == 0 || s.find("eval") == 0; });
+    nodes = 0;
 
-    TimePoint elapsed = now();
+    elapsed = now();
 
     for (const auto& cmd : list)
     {
@@ -184,17 +201,214 @@ namespace {
             {
                go(pos, is, states);
                Threads.main()->wait_for_search_finished();
-               nodes += Threads.nodes_searched();
+               nodes += Threads.nodes_searched() + Cluster::nodes_searched();
             }
             else
                trace_eval(pos);
         }
         else if (token == "setoption")  setoption(is);
         else if (token == "position")   position(pos, is, states);
-        else if (token == "ucinewgame") { Search::clear(); elapsed = now(); } // Search::clear() may take some while
+        else if (token == "ucinewgame")
+        {
+            Cluster::forward(cmd);
+            Search::clear();
+            elapsed = now(); // Search::clear() may take some while
+        }
     }
 
     elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+  }
+
+
+  // bench_positions() sets up the positions of a bench list, running its
+  // setoption commands, for the benches of the NNUE evaluation. Returns the
+  // limit of an "eval" bench, the number of times the positions are evaluated.
+
+  int bench_positions(const vector<string>& list, deque<StateInfo>& states, deque<Position>& positions) {
+
+    int passes = 1;
+
+    for (const auto& cmd : list)
+    {
+        string token, fen;
+        istringstream is(cmd);
+        is >> token;
+
+        if (token == "setoption")
+            setoption(is);
+
+        else if (token == "eval")
+            is >> passes;
+
+        else if (token == "position" && is >> token && token == "fen")
+        {
+            while (is >> token && token != "moves")
+                fen += token + " ";
+
+            states.emplace_back();
+            positions.emplace_back().set(fen, Options["UCI_Chess960"], &states.back(), Threads.main());
+        }
+    }
+
+    Eval::NNUE::verify();
+
+    return passes;
+  }
+
+
+  // bench_batch() compares the throughput of the NNUE evaluation of the bench
+  // positions one at a time and in a batch. The evaluations are run as many
+  // times as the limit of the bench, and the accumulators are computed again
+  // each time, as for new positions.
+
+  void bench_batch(const vector<string>& list) {
+
+    deque<StateInfo> states;
+    deque<Position> positions;
+    int passes = bench_positions(list, states, positions);
+    vector<const Position*> batch;
+
+    for (const Position& pos : positions)
+        batch.push_back(&pos);
+
+    vector<Value> single(batch.size()), batched(batch.size());
+    TimePoint elapsed[2];
+
+    auto reset = [&]() {
+        for (StateInfo& st : states)
+            st.accumulator->computed[WHITE] = st.accumulator->computed[BLACK] = false;
+    };
+
+    elapsed[0] = now();
+    for (int i = 0; i < passes; ++i)
+    {
+        reset();
+        for (size_t j = 0; j < batch.size(); ++j)
+            single[j] = Eval::NNUE::evaluate(*batch[j]);
+    }
+    elapsed[0] = now() - elapsed[0] + 1;
+
+    elapsed[1] = now();
+    for (int i = 0; i < passes; ++i)
+    {
+        reset();
+        Eval::NNUE::evaluate(batch.data(), batch.size(), batched.data());
+    }
+    elapsed[1] = now() - elapsed[1] + 1;
+
+    uint64_t evals = uint64_t(passes) * batch.size();
+
+    cerr << "\n===========================================================";
+    for (int i = 0; i < 2; ++i)
+        cerr << "\n" << left << setw(8) << (i ? "batch" : "single")
+             << " Total time (ms) : " << setw(8) << elapsed[i]
+             << " Evaluations : " << setw(10) << evals
+             << " Positions/second : " << 1000 * evals / elapsed[i];
+    cerr << "\nSpeedup : " << fixed << setprecision(2) << double(elapsed[0]) / elapsed[1] << defaultfloat
+         << "  Mismatches : " << inner_product(single.begin(), single.end(), batched.begin(), 0,
+                                               plus<int>(), not_equal_to<Value>()) << endl;
+  }
+
+
+  // bench_nnue() times the stages of the NNUE evaluation of the bench positions
+  // on their own, with warm and cold caches, see Eval::NNUE::benchmark(). The
+  // limit of the bench is the number of calls of a stage per position with warm
+  // caches. The results are written in CSV format.
+
+  void bench_nnue(const vector<string>& list) {
+
+    deque<StateInfo> states;
+    deque<Position> positions;
+    int passes = bench_positions(list, states, positions);
+    vector<Position*> corpus;
+
+    for (Position& pos : positions)
+        corpus.push_back(&pos);
+
+    cerr << "\n";
+    Eval::NNUE::benchmark(corpus.data(), corpus.size(), passes, cerr);
+  }
+
+
+  // bench() is called when engine receives the "bench" command. Firstly
+  // a list of UCI commands is setup according to bench parameters, then
+  // it is run one by one printing a summary at the end. If "smp" follows
+  // the bench parameters, the list is run once for each "SMP Mode" to
+  // compare their time to depth and nodes searched. With "cluster" it is
+  // run by this process alone and then with the workers of the cluster,
+  // the nodes searched by all the processes are counted. With "batch" the
+  // NNUE evaluations of the positions are timed instead, see bench_batch(),
+  // and with "nnue" the stages of these evaluations, see bench_nnue().
+
+  void bench(Position& pos, istream& args, StateListPtr& states) {
+
+    string compare;
+    uint64_t nodes;
+    TimePoint elapsed;
+
+    vector<string> list = setup_bench(pos, args);
+
+    if (args >> compare && compare == "batch")
+    {
+        bench_batch(list);
+        return;
+    }
+
+    if (compare == "nnue")
+    {
+        bench_nnue(list);
+        return;
+    }
+
+    if (compare == "smp" || compare == "cluster")
+    {
+        bool smp = compare == "smp";
+        vector<string> modes = smp ? vector<string>{ "LazySMP", "ABDADA" }
+                                   : vector<string>{ "single", "cluster" };
+        vector<pair<uint64_t, TimePoint>> results;
+        string current = Options["SMP Mode"];
+
+        for (const string& mode : modes)
+        {
+            if (smp)
+            {
+                istringstream is("name SMP Mode value " + mode);
+                setoption(is);
+            }
+            else
+                Cluster::suspend(mode == "single");
+
+            run_bench(pos, list, states, nodes, elapsed);
+            results.emplace_back(nodes, elapsed);
+        }
+
+        if (smp)
+        {
+            istringstream is("name SMP Mode value " + current);
+            setoption(is);
+        }
+
+        dbg_print(); // Just before exiting
+
+        cerr << "\n===========================================================";
+        for (size_t i = 0; i < modes.size(); ++i)
+            cerr << "\n" << left << setw(8) << modes[i]
+                 << " Total time (ms) : " << setw(8) << results[i].second
+                 << " Nodes searched : " << setw(11) << results[i].first
+                 << " Nodes/second : " << 1000 * results[i].first / results[i].second;
+
+        // Node efficiency is the share of the nodes searched by the cluster
+        // that a single process needs to reach the same depths.
+        if (!smp)
+            cerr << "\nWorkers : " << Cluster::workers()
+                 << "  Time to depth speedup : " << fixed << setprecision(2)
+                 << double(results[0].second) / results[1].second
+                 << "  Node efficiency : " << double(results[0].first) / results[1].first << defaultfloat;
+        cerr << endl;
+        return;
+    }
+
+    run_bench(pos, list, states, nodes, elapsed);
 
     dbg_print(); // Just before exiting
 
@@ -247,7 +461,9 @@ void UCI::loop(int argc, char* argv[]) {
       cmd += std::string(argv[i]) + " ";
 
   do {
-      if (argc == 1 && !getline(cin, cmd)) // Block here waiting for input or EOF
+      // Block here waiting for input or EOF. The commands of a cluster worker
+      // come from the coordinator, see Cluster::command().
+      if ((argc == 1 || Cluster::is_worker()) && !getline(cin, cmd))
           cmd = "quit";
 
       istringstream is(cmd);
@@ -257,14 +473,22 @@ void UCI::loop(int argc, char* argv[]) {
 
       if (    token == "quit"
           ||  token == "stop")
+      {
           Threads.stop = true;
+          Threads.main()->wake_up();
+          Cluster::forward(token);
+      }
 
       // The GUI sends 'ponderhit' to tell us the user has played the expected move.
       // So 'ponderhit' will be sent if we were told to ponder on the same move the
       // user has played. We should continue searching but switch from pondering to
       // normal search.
       else if (token == "ponderhit")
+      {
           Threads.main()->ponder = false; // Switch to normal search
+          Threads.main()->wake_up();
+          Cluster::forward(token);
+      }
 
       else if (token == "uci")
           sync_cout << "id name " << engine_info(true)
@@ -274,12 +498,19 @@ void UCI::loop(int argc, char* argv[]) {
       else if (token == "setoption")  setoption(is);
       else if (token == "go")         go(pos, is, states);
       else if (token == "position")   position(pos, is, states);
-      else if (token == "ucinewgame") Search::clear();
+      else if (token == "ucinewgame")
+      {
+          Cluster::forward(token);
+          Search::clear();
+      }
       else if (token == "isready")
       {
           //Make sure experience has finished loading
           Experience::wait_for_loading_finished();
 
+          // Histories are reset in the background after ucinewgame
+          Threads.wait_for_clear();
+
           sync_cout << "readyok" << sync_endl;
       }
 
@@ -287,9 +518,12 @@ void UCI::loop(int argc, char* argv[]) {
       // Do not use these commands during a search!
       else if (token == "flip")     pos.flip();
       else if (token == "bench")    bench(pos, is, states);
+      else if (token == "analyse")  Analysis::run(is);
+      else if (token == "selfplay") SelfPlay::run(is);
       else if (token == "d")        sync_cout << pos << sync_endl;
       else if (token == "eval")     trace_eval(pos);
       else if (token == "compiler") sync_cout << compiler_info() << sync_endl;
+      else if (token == "cluster")  Cluster::command(is);
       else if (argc > 2 && token == "defrag")   Experience::defrag(argc - 2, argv + 2);
       else if (argc > 2 && token == "merge")    Experience::merge(argc - 2, argv + 2);
       else if (token == "exp")                  Experience::show_exp(pos, false);
@@ -297,16 +531,28 @@ void UCI::loop(int argc, char* argv[]) {
       else if (argc > 2 && token == "convert_compact_pgn") Experience::convert_compact_pgn(argc - 2, argv + 2);
       else if (token == "export_net")
       {
+          // "export_net leb128" writes the default file in the given format
           std::optional<std::string> filename;
-          std::string f;
+          std::string f, format = "raw";
           if (is >> skipws >> f)
-              filename = f;
-          Eval::NNUE::save_eval(filename);
+          {
+              if (f == "raw" || f == "leb128")
+                  format = f;
+              else
+              {
+                  filename = f;
+                  is >> format;
+              }
+          }
+          if (format == "raw" || format == "leb128")
+              Eval::NNUE::save_eval(filename, format == "leb128");
+          else
+              sync_cout << "Unknown net format: " << format << ", use raw or leb128" << sync_endl;
       }
       else if (!token.empty() && token[0] != '#')
           sync_cout << "Unknown command: " << cmd << sync_endl;
 
-  } while (token != "quit" && argc == 1); // Command line args are one-shot
+  } while (token != "quit" && (argc == 1 || Cluster::is_worker())); // Command line args are one-shot
 }
 
 
@@ -21,6 +21,7 @@
 #include <ostream>
 #include <sstream>
 
+#include "cluster.h"
 #include "evaluate.h"
 #include "misc.h"
 #include "search.h"
@@ -42,15 +43,37 @@ namespace UCI {
 /// 'On change' actions, triggered by an option's value change
 void on_clear_hash(const Option&) { Search::clear(); }
 void on_hash_size(const Option& o) { TT.resize(size_t(o)); }
+void on_hash_shared_name(const Option&) { TT.resize(size_t(Options["Hash"])); }
+void on_cluster_listen(const Option& o) { Cluster::listen(o); }
 void on_logger(const Option& o) { start_logger(o); }
 void on_threads(const Option& o) { Threads.set(size_t(o)); }
-void on_tb_path(const Option& o) { Tablebases::init(o); }
+void on_thread_binding(const Option&) { Threads.set(size_t(Options["Threads"])); }
+void on_tb_path(const Option& o) { Tablebases::init(o); Tablebases::warm_up(int(Options["SyzygyWarmup"])); }
+void on_tb_warmup(const Option& o) { Tablebases::warm_up(int(o)); }
 void on_book1_file(const Option& o) { polybook[0].init(o); }
 void on_book2_file(const Option& o) { polybook[1].init(o); }
 void on_exp_enabled(const Option& /*o*/) { Experience::init(); }
 void on_exp_file(const Option& /*o*/) { Experience::init(); }
 void on_use_NNUE(const Option& ) { Eval::NNUE::init(); }
 void on_eval_file(const Option& ) { Eval::NNUE::init(); }
+void on_eval_file_shared_name(const Option&) { Eval::eval_file_loaded = "None"; Eval::NNUE::init(); }
+void on_prefetch_distance(const Option& o) { MovePicker::PrefetchDistance = int(o); }
+void on_large_pages_nnue(const Option&) { Eval::eval_file_loaded = "None"; Eval::NNUE::init(); }
+void on_large_pages(const Option&) {
+  TT.resize(size_t(Options["Hash"]));
+  if (Options["Large Pages NNUE"])
+      on_large_pages_nnue(Options["Large Pages NNUE"]);
+}
+
+/// large_page_size() translates the "Large Pages" option into the page size
+/// argument of aligned_large_pages_alloc(): 0 for the platform default (Auto),
+/// the explicit huge page size, or 4096 to disable large pages.
+size_t large_page_size() {
+
+  return  Options["Large Pages"] == "2MB" ? size_t(2) << 20
+        : Options["Large Pages"] == "1GB" ? size_t(1) << 30
+        : Options["Large Pages"] == "Off" ? 4096 : 0;
+}
 
 /// Our case insensitive less() function as required by UCI protocol
 bool CaseInsensitiveLess::operator() (const string& s1, const string& s2) const {
@@ -68,14 +91,23 @@ void init(OptionsMap& o) {
 
   o["Debug Log File"]                  << Option("", on_logger);
   o["Threads"]                         << Option(1, 1, 512, on_threads);
+  o["Thread Binding"]                  << Option("auto var none var compact var scatter var auto", "auto", on_thread_binding);
+  o["SMP Mode"]                        << Option("LazySMP var LazySMP var ABDADA", "LazySMP");
+  o["Cluster Listen"]                  << Option("<empty>", on_cluster_listen);
   o["Hash"]                            << Option(16, 1, MaxHashMB, on_hash_size);
   o["Clear Hash"]                      << Option(on_clear_hash);
+  o["Hash Shared Name"]                << Option("<empty>", on_hash_shared_name);
+  o["Perft Hash"]                      << Option(16, 0, MaxHashMB);
+  o["Large Pages"]                     << Option("Auto var Auto var 2MB var 1GB var Off", "Auto", on_large_pages);
+  o["Large Pages NNUE"]                << Option(false, on_large_pages_nnue);
   o["Ponder"]                          << Option(false);
   o["MultiPV"]                         << Option(1, 1, 500);
+  o["MultiPV Split"]                   << Option(false);
   o["Skill Level"]                     << Option(20, 0, 20);
   o["Move Overhead"]                   << Option(10, 0, 5000);
   o["Slow Mover"]                      << Option(100, 10, 1000);
   o["nodestime"]                       << Option(0, 0, 10000);
+  o["Prefetch Distance"]               << Option(2, 0, 8, on_prefetch_distance);
   o["UCI_Chess960"]                    << Option(false);
   o["UCI_AnalyseMode"]                 << Option(false);
   o["UCI_DepthLimit"]     	           << Option(42, 12, 99);  
@@ -87,6 +119,7 @@ void init(OptionsMap& o) {
   o["SyzygyProbeDepth"]                << Option(1, 1, 100);
   o["Syzygy50MoveRule"]                << Option(true);
   o["SyzygyProbeLimit"]                << Option(7, 0, 7);
+  o["SyzygyWarmup"]                    << Option(0, 0, 7, on_tb_warmup);
   o["Book1"]                           << Option(false);
   o["Book1 File"]                      << Option("<empty>", on_book1_file);
   o["Book1 BestBookMove"]              << Option(true);
@@ -104,6 +137,7 @@ void init(OptionsMap& o) {
   o["Experience Book Min Depth"]       << Option(27, EXP_MIN_DEPTH, 64);
   o["Experience Book Max Moves"]       << Option(16, 1, 100);
   o["EvalFile"]                        << Option(EvalFileDefaultName, on_eval_file);
+  o["EvalFile Shared Name"]            << Option("<empty>", on_eval_file_shared_name);
   o["Use NNUE Evaluation"]             << Option(true, on_use_NNUE);
   o["Use Classical Evaluation"]        << Option(true);
 }
@@ -0,0 +1,54 @@
+#!/bin/bash
+# verify that a finished ponder/infinite search waits without using the CPU
+# and that it answers "ponderhit" and "stop" without delay
+
+error()
+{
+  echo "ponder testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "ponder testing started"
+
+cat << EOF > ponder.exp
+   set timeout 10
+   lassign \$argv go answer maxms
+   spawn ./stockfish
+   set pid [exp_pid]
+
+   proc cputicks {pid} {
+      if {![file exists /proc/\$pid/stat]} { return 0 }
+      set f [open /proc/\$pid/stat]
+      set fields [split [read \$f]]
+      close \$f
+      return [expr {[lindex \$fields 13] + [lindex \$fields 14]}]
+   }
+
+   send "setoption name Ponder value true\\nsetoption name Use NNUE Evaluation value false\\n"
+   send "position startpos\\n\$go\\n"
+   expect "info depth 4 " {} timeout {exit 1}
+
+   # The search is over, the engine must now wait for the GUI
+   sleep 0.5
+   set ticks [cputicks \$pid]
+   sleep 1
+   if {[cputicks \$pid] - \$ticks > 10} { puts "busy waiting"; exit 1 }
+
+   set start [clock milliseconds]
+   send "\$answer\\n"
+   expect "bestmove" {} timeout {exit 1}
+   set elapsed [expr {[clock milliseconds] - \$start}]
+   if {\$elapsed > \$maxms} { puts "\$answer took \$elapsed ms"; exit 1 }
+
+   send "quit\\n"
+   expect eof
+EOF
+
+expect ponder.exp "go ponder depth 4 wtime 60000 btime 60000" ponderhit 100 > /dev/null
+expect ponder.exp "go ponder depth 4 wtime 60000 btime 60000" stop 100 > /dev/null
+expect ponder.exp "go infinite depth 4" stop 100 > /dev/null
+
+rm ponder.exp
+
+echo "ponder testing OK"